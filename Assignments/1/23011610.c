@@ -19,6 +19,7 @@ int partition(int[], int, int, int);
 void quicksort(int[], int[], int, int);
 struct Data *readInput(char[]);
 
+#ifndef BENCHMARK
 int main() {
     srand(time(NULL));
     
@@ -42,6 +43,7 @@ int main() {
     
     return 0;
 }
+#endif
 
 /**
  * @brief Simple swap function used to swap array elements.
@@ -125,15 +127,18 @@ void quicksort(int keys[], int locks[], int left, int right) {
     int pivot = partition(locks, left, right, keys[right]);         /**< Get the corresponding element to that random index */
                                                                     /**< Partition the locks array using chosen random key */ 
 
+#ifndef BENCHMARK
     printf("\nRandom pivot: %d\n", keys[right]);
+#endif
 
     partition(keys, left, right, locks[pivot]);                     /**< Partition the keys array using the chosen random key */
 
-
+#ifndef BENCHMARK                                                   /**< Traces would swamp the sort in benchmark builds */
     fputs("Keys partitioned around random pivot: ", stdout);
     print(keys, left, right);
     fputs("Locks partitioned around random pivot: ", stdout);
     print(locks, left, right);
+#endif
 
     quicksort(keys, locks, left, pivot-1);                          
     quicksort(keys, locks, pivot+1, right);
@@ -42,6 +42,7 @@ int **playSongs(playlist **, size_t);
 data *readInput(char*);
 size_t computeListenedSongCount(int*, size_t);
 
+#ifndef BENCHMARK
 int main() {
   srand(time(NULL));
 
@@ -61,6 +62,7 @@ int main() {
   free(data);
   return 0;
 }
+#endif
 
 /**
  * @brief Computes total playtime for each song in their playlist by traversing their playlist
@@ -84,6 +84,7 @@ void addNode(NodeInput *, char *, Node *, size_t);
 Node *findNode(NodeInput *, char *, size_t);
 void freeTree(Node *);
 
+#ifndef BENCHMARK
 int main() {
   Node *root = readData(FILE_PATH);
   
@@ -96,6 +97,7 @@ int main() {
   freeTree(root);
   return 0;
 }
+#endif
 
 /**
  * @brief Instantiates a dynamic queue with a linked list container.
@@ -1,297 +1,2415 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* OpenMP directives of the batch resolver, left out of builds without -fopenmp. */
+#ifdef _OPENMP
+#define OMP(directive) _Pragma(OMP_TEXT(omp directive))
+#define OMP_TEXT(text) #text
+#else
+#define OMP(directive)
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #define FILE_PATH "input.txt"
 
-typedef struct GraphNode {
-  int name;
-  struct GraphNode *next;
-} GraphNode;
+/* Input file is read in blocks of this size instead of line by line. */
+#define READ_BLOCK_SIZE (1 << 20)
+
+/* Binary graph files, see `writeGraph`. */
+#define GRAPH_MAGIC "BLMGRPH1"
+#define GRAPH_BYTE_ORDER 0x01020304u
+#define GRAPH_HAS_NAMES 1u
+
+/* Answers kept for every vertex by `trackAnswers`. */
+#define ANSWER_NONE 0
+#define ANSWER_NO 1
+#define ANSWER_YES 2
+
+/* Vertex renumbering methods of `reorderGraph`. */
+#define ORDER_NONE 0
+#define ORDER_BFS 1
+#define ORDER_RCM 2
+#define ORDER_DEGREE 3
+
+#define WORD_BITS 64
+
+/*
+ * Direction switches of `growBall`: go bottom-up once the frontier has more than 1/ALPHA of the
+ * unexplored edges, come back top-down once it holds less than 1/BETA of the vertices.
+ */
+#define SWITCH_ALPHA 14
+#define SWITCH_BETA 24
+
+#if defined(__GNUC__) || defined(__clang__)
+#define countTrailingZeros(word) __builtin_ctzll(word)
+#define popCount(word) __builtin_popcountll(word)
+#else
+int countTrailingZeros(uint64_t);
+int popCount(uint64_t);
+#endif
 
+/*
+ * Adjacency lists are stored in compressed sparse row form: neighbors of vertex `u` are
+ * `neighbors[offsets[u]]` up to (excluding) `neighbors[ends[u]]`, sorted in ascending order.
+ * While the graph is never updated, `ends` is `offsets + 1` and lists are packed. The first
+ * `addEdge` or `removeEdge` gives every list its own block ending at `limits[u]` with free slots,
+ * blocks that outgrow their slots move behind `used` and leave `garbage` until the next compaction.
+ * After renumbering, `names[u]` is the input name of vertex `u` and `ids[name]` maps back;
+ * both are NULL while vertices keep their input names.
+ * A graph from `mapGraph` keeps `offsets`, `neighbors`, `names` and `ids` inside the `mapping`
+ * of its file, `mapping` is NULL for graphs in allocated memory.
+ */
 typedef struct {
   size_t vertices;
-  GraphNode **nodes;
+  size_t edges;
+  size_t *offsets;
+  size_t *ends;
+  size_t *limits;
+  int *neighbors;
+  size_t capacity;
+  size_t used;
+  size_t garbage;
+  int *names;
+  int *ids;
+  void *mapping;
+  size_t mappingSize;
 } Graph;
 
+/*
+ * Start of a binary graph file. It is followed by `vertices + 1` offsets as 64-bit integers,
+ * `edges` neighbors as 32-bit integers and, with GRAPH_HAS_NAMES, `vertices` names and ids.
+ */
+typedef struct {
+  char magic[8];
+  uint32_t byteOrder;
+  uint32_t flags;
+  uint64_t vertices;
+  uint64_t edges;
+} GraphFileHeader;
+
+/* One bit per vertex, packed into 64-bit words. */
+typedef struct {
+  size_t bits;
+  size_t words;
+  uint64_t *data;
+} Bitset;
+
+/*
+ * Breadth-first search that collects every vertex within `radius` steps of a set of sources, at least
+ * one step away. Levels run top-down from a frontier list, or bottom-up over the reverse graph from a
+ * frontier bitset when the frontier gets large. While every level ran top-down, `members` lists the
+ * `size` vertices of `ball`; after a bottom-up level it is only scratch space and `sparse` is false.
+ */
+typedef struct {
+  Graph *g;
+  Graph *reverse;     /* NULL to always run top-down. */
+  size_t radius;
+  Bitset *ball;
+  Bitset *frontier;
+  Bitset *next;
+  int *members;
+  size_t count;
+  size_t size;
+  int sparse;
+} BallSearch;
+
+/*
+ * Questions of the form "is the `prize` within `radius` steps?". `forward` answers them, `backward`
+ * runs over the reverse graph from all candidates at once to find the vertices that can still reach
+ * a candidate, and is grown again each time the candidates halve.
+ */
+typedef struct {
+  BallSearch *forward;
+  BallSearch *backward;
+  int *sources;
+  size_t reachCandidates;   /* Candidate count when `backward` was grown, 0 if not grown yet. */
+} DistanceQuery;
+
+/*
+ * Candidate state of a search. `alive` holds vertices that no "Not adjacent" answer ruled out,
+ * `best` holds vertices that were inside every "Adjacent" answer. Most feasible vertices are
+ * `alive & best`, or all of `alive` while no "Adjacent" answer came yet; `candidates` is their count.
+ * With `trackAnswers`, every answer and how many "Not adjacent"/"Adjacent" neighbor sets hold each
+ * vertex are kept as well, so edge updates can correct the candidates without a new search.
+ * `distance` is NULL for adjacency questions, or the borrowed engine of distance questions.
+ */
+typedef struct {
+  Bitset *alive;
+  Bitset *best;
+  Bitset *scratch;
+  size_t adjacentAnswers;
+  size_t candidates;
+  char *answers;      /* ANSWER_ value of every vertex, NULL while not tracking. */
+  unsigned *noHits;
+  unsigned *yesHits;
+  DistanceQuery *distance;
+} SearchState;
+
+/*
+ * Context of the greedy strategy. `score[q]` is the number of candidates adjacent to `q`, kept in
+ * buckets by score and updated through the reverse graph whenever candidates are ruled out.
+ */
+typedef struct {
+  Graph *reverse;
+  Bitset *known;      /* Candidates as of the previous pick. */
+  size_t *score;
+  size_t *bucketHead;
+  size_t *next;
+  size_t *prev;
+  size_t top;         /* Every bucket above `top` is empty. */
+  size_t maxScore;
+  size_t lastPick;
+  size_t lastAdjacentAnswers;
+} GreedyContext;
+
+/* Picks the next vertex to ask about, or returns `g->vertices` when no question is left. */
+typedef size_t (*QueryStrategy)(Graph *g, SearchState *state, void *context);
+
+/* Outcome of one prize lookup in batch mode. */
+typedef struct {
+  int prize;
+  size_t questions;
+  size_t count;
+  int *chosen;
+} BatchResult;
+
+/* Edges collected while the input is being parsed, turned into a `Graph` by `buildGraph`. */
+typedef struct {
+  size_t vertices;
+  size_t count;
+  size_t capacity;
+  int *from;
+  int *to;
+  size_t *degree;
+} GraphBuilder;
+
+/* Parser state kept between input blocks, so numbers and lines may span block borders. */
+typedef struct {
+  GraphBuilder *builder;
+  size_t vertices;
+  size_t lines;
+  int headerRead;     /* 0: no vertex count yet, 1: vertex count read, 2: header line finished. */
+  int inNumber;
+  long long value;
+  long long source;
+} InputScanner;
+
 Graph *readInput(char *);
-GraphNode *createGraphNode(int);
-Graph *createGraph(size_t);
-void addEdge(Graph *, int, int);
+void writeGraph(Graph *, char *);
+Graph *mapGraph(char *);
+void unmapFile(void *, size_t);
+int inMapping(Graph *, const void *);
+void scanBlock(InputScanner *, const char *, size_t);
+void scanNumber(InputScanner *);
+void scanLineEnd(InputScanner *);
+GraphBuilder *createGraphBuilder(size_t);
+Graph *createGraph(size_t, size_t);
+void collectEdge(GraphBuilder *, int, int);
+Graph *buildGraph(GraphBuilder *);
+void makeDynamic(Graph *);
+void compactGraph(Graph *);
+void relocateList(Graph *, int);
+size_t findNeighbor(Graph *, size_t, int);
+int addEdge(Graph *, int, int);
+int removeEdge(Graph *, int, int);
+Graph *transposeGraph(Graph *);
+int *vertexOrder(Graph *, int);
+Graph *reorderGraph(Graph *, int);
+int vertexName(Graph *, size_t);
+int vertexId(Graph *, int);
+Bitset *createBitset(size_t, int);
+void fillBitset(Bitset *, int);
+void freeBitset(Bitset *);
+SearchState *createSearchState(size_t);
+void resetSearchState(SearchState *);
+void trackAnswers(SearchState *);
+void forgetAnswer(Graph *, SearchState *, size_t);
+void updateCandidates(SearchState *, int, int, int);
+void freeSearchState(SearchState *);
 void printGraph(Graph *);
-void printNodes(Graph *, int *);
-void printMostFeasible(Graph *, int *);
-void searchGraph(Graph *, int);
-void checkAdjacency(GraphNode *, int *, int);
-int allNeighborsChecked(GraphNode *, int *);
+void printBits(Graph *, Bitset *, Bitset *);
+void printNodes(Graph *, SearchState *);
+void printMostFeasible(Graph *, SearchState *);
+BallSearch *createBallSearch(Graph *, Graph *, size_t);
+void freeBallSearch(BallSearch *);
+void clearBall(BallSearch *);
+size_t growBall(BallSearch *, const int *, size_t);
+size_t expandTopDown(BallSearch *, const int *, size_t);
+size_t expandBottomUp(BallSearch *, size_t *);
+DistanceQuery *createDistanceQuery(Graph *, Graph *, size_t);
+void freeDistanceQuery(DistanceQuery *);
+int canReachCandidate(size_t, SearchState *);
+int checkDistance(size_t, SearchState *, int);
+void narrowByList(SearchState *, const int *, const int *, int);
+void narrowBySet(SearchState *, const Bitset *, int);
+size_t searchGraph(Graph *, int, QueryStrategy, void *, DistanceQuery *);
+size_t resolvePrize(Graph *, SearchState *, int, QueryStrategy, void *, int);
+int *readPrizes(char *, size_t, size_t *);
+void resolveBatch(Graph *, Graph *, BatchResult *, size_t);
+void printBatch(BatchResult *, size_t);
+double wallTime();
+size_t sequentialStrategy(Graph *, SearchState *, void *);
+GreedyContext *createGreedyContext(Graph *, Graph *);
+void resetGreedyContext(GreedyContext *);
+void freeGreedyContext(GreedyContext *);
+void moveToBucket(GreedyContext *, size_t, size_t);
+void updateScores(GreedyContext *, SearchState *, size_t);
+void rebuildScores(GreedyContext *, SearchState *);
+size_t greedyStrategy(Graph *, SearchState *, void *);
+int isCandidate(SearchState *, int);
+int isNeighbor(Graph *, size_t, int);
+int checkAdjacency(Graph *, size_t, SearchState *, int);
+int allNeighborsChecked(Graph *, size_t, SearchState *);
 void freeGraph(Graph *);
+int compareInts(const void *, const void *);
+
+#ifndef BENCHMARK
+int main(int argc, char *argv[]) {
+  int greedy = 0;
+  int order = ORDER_NONE;
+  size_t radius = 1;
+  char *batchPath = NULL;
+  char *loadPath = NULL;
+  char *convertPath = NULL;
+
+  int i = 1;
+  for (; i < argc; ++i) {
+    if (strcmp(argv[i], "--greedy") == 0) {
+      greedy = 1;
+    } else if (strcmp(argv[i], "--reorder") == 0 && i + 1 < argc) {
+      ++i;
+      if (strcmp(argv[i], "bfs") == 0) {
+        order = ORDER_BFS;
+      } else if (strcmp(argv[i], "rcm") == 0) {
+        order = ORDER_RCM;
+      } else if (strcmp(argv[i], "degree") == 0) {
+        order = ORDER_DEGREE;
+      } else {
+        fprintf(stderr, "Unknown order %s.\n", argv[i]);
+        exit(EXIT_FAILURE);
+      }
+    } else if (strcmp(argv[i], "--distance") == 0 && i + 1 < argc) {
+      long long value = atoll(argv[++i]);
+      if (value < 1) {
+        fprintf(stderr, "Distance must be at least 1.\n");
+        exit(EXIT_FAILURE);
+      }
+      radius = (size_t)value;
+    } else if (strcmp(argv[i], "--load") == 0 && i + 1 < argc) {
+      loadPath = argv[++i];
+    } else if (strcmp(argv[i], "--convert") == 0 && i + 1 < argc) {
+      convertPath = argv[++i];
+    } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+      batchPath = argv[++i];
+    } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+#ifdef _OPENMP
+      omp_set_num_threads(atoi(argv[++i]));
+#else
+      ++i;
+      fputs("Built without OpenMP, running on one thread.\n", stderr);
+#endif
+    } else {
+      fprintf(stderr, "Unknown option %s.\n", argv[i]);
+      exit(EXIT_FAILURE);
+    }
+  }
+  if (radius > 1 && (greedy || batchPath)) {
+    fputs("Distance questions only run with the sequential strategy outside batch mode.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+
+  Graph *graph = loadPath ? mapGraph(loadPath) : readInput(FILE_PATH);
+  if (order != ORDER_NONE) {
+    Graph *ordered = reorderGraph(graph, order);
+    freeGraph(graph);
+    graph = ordered;
+  }
+
+  if (convertPath) {
+    writeGraph(graph, convertPath);
+    freeGraph(graph);
+    return 0;
+  }
+
+  if (batchPath) {
+    size_t count;
+    int *prizes = readPrizes(batchPath, graph->vertices, &count);
+    BatchResult *results = calloc(count ? count : 1, sizeof(*results));
+    size_t k = 0;
+    for (; k < count; ++k) {
+      results[k].prize = prizes[k];
+    }
+
+    Graph *reverse = greedy ? transposeGraph(graph) : NULL;
+    double start = wallTime();
+    resolveBatch(graph, reverse, results, count);
+    double elapsed = wallTime() - start;
 
-int main() {
-  Graph *graph = readInput(FILE_PATH);
+    printBatch(results, count);
+    fprintf(stderr, "Resolved %llu prizes in %.3f s (%.0f queries/s).\n", count, elapsed,
+            elapsed > 0 ? count / elapsed : 0.0);
+
+    for (k = 0; k < count; ++k) {
+      free(results[k].chosen);
+    }
+    free(results);
+    free(prizes);
+    freeGraph(reverse);
+    freeGraph(graph);
+    return 0;
+  }
   
   int prize;
   fputs("Enter prize node: ", stdout);
-  fscanf(stdin, "%d", &prize);
+  if (fscanf(stdin, "%d", &prize) != 1 || prize < 0 || (size_t)prize >= graph->vertices) {
+    fputs("Prize out of range.\n", stderr);
+    freeGraph(graph);
+    exit(EXIT_FAILURE);
+  }
   fputc('\n', stdout);
+  prize = vertexId(graph, prize);
 
-  searchGraph(graph, prize);
+  if (greedy) {
+    Graph *reverse = transposeGraph(graph);
+    GreedyContext *context = createGreedyContext(graph, reverse);
+    searchGraph(graph, prize, greedyStrategy, context, NULL);
+    freeGreedyContext(context);
+    freeGraph(reverse);
+  } else if (radius > 1) {
+    Graph *reverse = transposeGraph(graph);
+    DistanceQuery *distance = createDistanceQuery(graph, reverse, radius);
+    size_t cursor = 0;
+    searchGraph(graph, prize, sequentialStrategy, &cursor, distance);
+    freeDistanceQuery(distance);
+    freeGraph(reverse);
+  } else {
+    size_t cursor = 0;
+    searchGraph(graph, prize, sequentialStrategy, &cursor, NULL);
+  }
 
   freeGraph(graph);
   return 0;
 }
+#endif
 
 /**
- * Creates a Graph Node with given name.
+ * Creates an empty edge collector for a graph with given vertex count.
  *
- * @param name Name of the node.
+ * @param vertices Vertex count of the graph.
  *
- * @return Newly created node.
+ * @return Pointer to newly created GraphBuilder object.
  */
-GraphNode *createGraphNode(int name) {
-  GraphNode *node = malloc(sizeof(*node));
-  node->name = name;
-  node->next = NULL;
+GraphBuilder *createGraphBuilder(size_t vertices) {
+  GraphBuilder *builder = malloc(sizeof(*builder));
+  builder->vertices = vertices;
+  builder->count = 0;
+  builder->capacity = (vertices > 16) ? vertices : 16;
+  builder->from = malloc(builder->capacity * sizeof(*builder->from));
+  builder->to = malloc(builder->capacity * sizeof(*builder->to));
+  builder->degree = calloc(vertices, sizeof(*builder->degree));
 
-  return node;
+  return builder;
 }
 
 /**
- * Creates a graph with given vertex count.
+ * Creates a graph with given vertex and edge count. Offsets and neighbors are left to the caller.
  *
  * @param vertices Vertex count of the graph.
+ * @param edges Edge count of the graph.
  *
  * @return Pointer to newly created Graph object.
  */
-Graph *createGraph(size_t vertices) {
+Graph *createGraph(size_t vertices, size_t edges) {
   Graph *graph = malloc(sizeof(*graph));
   graph->vertices = vertices;
-  graph->nodes = malloc(vertices * sizeof(*graph->nodes));
-
-  size_t i = 0;
-  for (; i < vertices; ++i) {
-    graph->nodes[i] = NULL;
-  }
+  graph->edges = edges;
+  graph->offsets = calloc(vertices + 1, sizeof(*graph->offsets));
+  graph->ends = graph->offsets + 1;
+  graph->limits = NULL;
+  graph->neighbors = malloc((edges ? edges : 1) * sizeof(*graph->neighbors));
+  graph->capacity = edges;
+  graph->used = edges;
+  graph->garbage = 0;
+  graph->names = NULL;
+  graph->ids = NULL;
+  graph->mapping = NULL;
+  graph->mappingSize = 0;
 
   return graph;
 }
 
 /**
- * Creates an edge between two node pairs.
+ * Collects an edge between two node pairs for the graph being built.
  *
  * @param u, v Name of the nodes around the edge.
  */
-void addEdge(Graph *g, int u, int v) {
+void collectEdge(GraphBuilder *b, int u, int v) {
   if (u == v) {
     return;
   }
 
-  GraphNode *node = createGraphNode(v);
-  node->next = g->nodes[u];
-  g->nodes[u] = node;
+  if (b->count == b->capacity) {
+    b->capacity *= 2;
+    b->from = realloc(b->from, b->capacity * sizeof(*b->from));
+    b->to = realloc(b->to, b->capacity * sizeof(*b->to));
+  }
+  b->from[b->count] = u;
+  b->to[b->count] = v;
+  ++b->count;
+  ++b->degree[u];
 }
 
 /**
- * Prints the graph with all its vertices and adjacent vertices to it. 
- * 
- * @param g Pointer to the graph object to be printed.
+ * Turns collected edges into a graph with two counting sort passes and frees the builder.
+ * Edges are first bucketed by target, then scattered to their source in target order, so
+ * every adjacency list comes out sorted in ascending order. Repeated edges are kept once.
+ *
+ * @param b Pointer to builder holding the edges.
+ *
+ * @return Pointer to newly created Graph object.
  */
-void printGraph(Graph *g) {
+Graph *buildGraph(GraphBuilder *b) {
+  Graph *graph = createGraph(b->vertices, b->count);
+
   size_t i = 0;
-  for (; i < g->vertices; ++i) {
-    GraphNode *temp = g->nodes[i];
-    fprintf(stdout, "%llu: ", i);
-    while (temp) {
-      fprintf(stdout, "%d -> ", temp->name);
-      temp = temp->next;
+  for (; i < b->vertices; ++i) {
+    graph->offsets[i + 1] = graph->offsets[i] + b->degree[i];
+  }
+
+  /* Sources of the edges bucketed by target, `targetStart[t]` is where bucket `t` begins. */
+  size_t *targetStart = calloc(b->vertices + 1, sizeof(*targetStart));
+  int *bySource = malloc((b->count ? b->count : 1) * sizeof(*bySource));
+  for (i = 0; i < b->count; ++i) {
+    ++targetStart[b->to[i] + 1];
+  }
+  for (i = 0; i < b->vertices; ++i) {
+    targetStart[i + 1] += targetStart[i];
+  }
+  for (i = 0; i < b->count; ++i) {
+    bySource[targetStart[b->to[i]]++] = b->from[i];
+  }
+
+  /* `degree` is reused as the write cursor of every vertex. */
+  memset(b->degree, 0, b->vertices * sizeof(*b->degree));
+  size_t k = 0;
+  for (i = 0; i < b->vertices; ++i) {
+    /* After the scatter above, `targetStart[i]` is where bucket `i` ends. */
+    for (; k < targetStart[i]; ++k) {
+      int u = bySource[k];
+      graph->neighbors[graph->offsets[u] + b->degree[u]++] = (int)i;
+    }
+  }
+
+  /* Repeated edges sit next to each other in sorted lists, lists are compacted in place. */
+  size_t write = 0;
+  size_t read = 0;
+  for (i = 0; i < b->vertices; ++i) {
+    size_t end = graph->offsets[i + 1];
+    graph->offsets[i] = write;
+    for (; read < end; ++read) {
+      if (write == graph->offsets[i] || graph->neighbors[write - 1] != graph->neighbors[read]) {
+        graph->neighbors[write++] = graph->neighbors[read];
+      }
     }
-    fputs("NULL\n", stdout);
   }
+  graph->offsets[b->vertices] = write;
+  graph->edges = write;
+  graph->used = write;
+
+  free(targetStart);
+  free(bySource);
+  free(b->from);
+  free(b->to);
+  free(b->degree);
+  free(b);
+
+  return graph;
 }
 
 /**
- * Prints vertices of a graph that are possible `prize` vertices.
- * 
- * @param g Pointer to the graph object to be printed.
- * @param feasible Array that lists all vertices' being `prize` vertex probability.
+ * Turns a packed graph into its updatable form, where every adjacency list has its own block.
+ *
+ * @param g Pointer to graph object to be turned.
+ */
+void makeDynamic(Graph *g) {
+  size_t n = g->vertices ? g->vertices : 1;
+  size_t *ends = malloc(n * sizeof(*ends));
+  memcpy(ends, g->offsets + 1, g->vertices * sizeof(*ends));
+
+  g->ends = ends;
+  g->limits = malloc(n * sizeof(*g->limits));
+  compactGraph(g);
+}
+
+/**
+ * Packs the blocks of an updatable graph again in vertex order, dropping the space of moved blocks.
+ * Every list gets half its length plus two free slots, so the next few inserts stay in place.
+ *
+ * @param g Pointer to updatable graph object to be compacted.
  */
-void printNodes(Graph *g, int *feasible) {
+void compactGraph(Graph *g) {
+  size_t total = 0;
   size_t i = 0;
   for (; i < g->vertices; ++i) {
-    if (feasible[i] != -1) {
-      fprintf(stdout, "%llu ", i);
-    }
+    size_t degree = g->ends[i] - g->offsets[i];
+    total += degree + degree / 2 + 2;
+  }
+
+  int *neighbors = malloc((total ? total : 1) * sizeof(*neighbors));
+  size_t write = 0;
+  for (i = 0; i < g->vertices; ++i) {
+    size_t degree = g->ends[i] - g->offsets[i];
+    memcpy(neighbors + write, g->neighbors + g->offsets[i], degree * sizeof(*neighbors));
+    g->offsets[i] = write;
+    g->ends[i] = write + degree;
+    g->limits[i] = write + degree + degree / 2 + 2;
+    write = g->limits[i];
+  }
+
+  /* Neighbors of a mapped graph stay in its file until the graph is freed. */
+  if (!inMapping(g, g->neighbors)) {
+    free(g->neighbors);
   }
+  g->neighbors = neighbors;
+  g->capacity = total;
+  g->used = total;
+  g->garbage = 0;
 }
 
 /**
- * Out of feasible list, prints the vertices with the most probability. It may be more than one vertex.
- * 
- * @param g Pointer to the graph object to be printed.
- * @param feasible Array that lists all vertices' being `prize` vertex probability.
+ * Moves a full adjacency list behind the last block with twice the room. Compacts the whole graph
+ * instead once moved blocks waste more than half of the used space.
+ *
+ * @param g Pointer to updatable graph object.
+ * @param u Vertex whose list is full.
  */
-void printMostFeasible(Graph *g, int *feasible) {
-  int mostFeasible = feasible[0];
+void relocateList(Graph *g, int u) {
+  if (g->garbage > g->used / 2) {
+    compactGraph(g);
+    return;
+  }
 
-  size_t i = 0;
-  for (; i < g->vertices; ++i) {
-    mostFeasible = (feasible[i] > mostFeasible) ? feasible[i] : mostFeasible;
+  size_t degree = g->ends[u] - g->offsets[u];
+  size_t room = 2 * degree + 2;
+  if (g->used + room > g->capacity) {
+    g->capacity = (2 * g->capacity > g->used + room) ? 2 * g->capacity : g->used + room;
+    g->neighbors = realloc(g->neighbors, g->capacity * sizeof(*g->neighbors));
   }
-  for (i = 0; i < g->vertices; ++i) {
-    if (feasible[i] == mostFeasible) {
-      fprintf(stdout, "%llu ", i);
-    }
+
+  memcpy(g->neighbors + g->used, g->neighbors + g->offsets[u], degree * sizeof(*g->neighbors));
+  g->garbage += g->limits[u] - g->offsets[u];
+  g->offsets[u] = g->used;
+  g->ends[u] = g->used + degree;
+  g->limits[u] = g->used + room;
+  g->used += room;
+}
+
+/**
+ * Inserts the edge `u -> v` into its sorted place. The first update turns the graph updatable.
+ *
+ * @param g Pointer to graph object to be updated.
+ * @param u, v Vertices around the edge.
+ *
+ * @return True if the edge is new, false if it already existed or is a loop.
+ */
+int addEdge(Graph *g, int u, int v) {
+  if (u == v) {
+    return 0;
+  }
+  if (!g->limits) {
+    makeDynamic(g);
+  }
+
+  size_t at = findNeighbor(g, u, v);
+  if (at < g->ends[u] && g->neighbors[at] == v) {
+    return 0;
   }
+  if (g->ends[u] == g->limits[u]) {
+    at -= g->offsets[u];
+    relocateList(g, u);
+    at += g->offsets[u];
+  }
+
+  memmove(g->neighbors + at + 1, g->neighbors + at, (g->ends[u] - at) * sizeof(*g->neighbors));
+  g->neighbors[at] = v;
+  ++g->ends[u];
+  ++g->edges;
+
+  return 1;
 }
 
 /**
- * Checks and returns true if a vertex's adjacent vertices' are all non-feasible for being the `prize` vertex.
- * 
- * @param node Pointer to graph node object to be checked.
- * @param feasible Array that lists all vertices' being `prize` vertex probability.
- * 
- * @return True if all non-feasible, false if not.
+ * Removes the edge `u -> v`, closing the gap inside its list. The first update turns the graph updatable.
+ *
+ * @param g Pointer to graph object to be updated.
+ * @param u, v Vertices around the edge.
+ *
+ * @return True if the edge was removed, false if it did not exist.
  */
-int allNeighborsChecked(GraphNode *node, int *feasible) {
-  GraphNode *temp = node;
-  while (temp) {
-    if (feasible[temp->name] != -1) {
-      return 0;
-    }
-    temp = temp->next;
+int removeEdge(Graph *g, int u, int v) {
+  if (!g->limits) {
+    makeDynamic(g);
   }
+
+  size_t at = findNeighbor(g, u, v);
+  if (at == g->ends[u] || g->neighbors[at] != v) {
+    return 0;
+  }
+
+  memmove(g->neighbors + at, g->neighbors + at + 1, (g->ends[u] - at - 1) * sizeof(*g->neighbors));
+  --g->ends[u];
+  --g->edges;
+
   return 1;
 }
 
 /**
- * Checks all adjacent vertices of a graph node and updates their feasibleness by asking if the node is a neighbor to `prize` node.
- * 
- * @param[in] node Pointer to graph node object to be checked.
- * @param[out] feasible Array that lists all vertices' being `prize` vertex probability.
- * @param[in] prize Name of the `prize` node.
+ * Creates the reverse of a graph, where every edge `u -> v` becomes `v -> u`.
+ * Sources are visited in ascending order, so reverse adjacency lists are sorted as well.
+ *
+ * @param g Pointer to graph object to be reversed.
+ *
+ * @return Pointer to newly created Graph object.
  */
-void checkAdjacency(GraphNode *node, int *feasible, int prize) {
-  GraphNode *temp = node;
+Graph *transposeGraph(Graph *g) {
+  Graph *reverse = createGraph(g->vertices, g->edges);
 
-  /* If an adjacent vertex is the `prize` node, mark node adjacent to prize. */
-  int prizeAdjacent = 0;
-  while (temp) {
-    if (temp->name == prize) {
-      prizeAdjacent = 1;
+  size_t i = 0;
+  for (; i < g->vertices; ++i) {
+    size_t j = g->offsets[i];
+    for (; j < g->ends[i]; ++j) {
+      ++reverse->offsets[g->neighbors[j] + 1];
     }
-    temp = temp->next;
   }
-  
-  /* 
-   * If the node is adjacent to prize, update it's neighbors' feasibleness; if not, mark them all -1
-   * since they cannot be the `prize` node.
-   */
-  temp = node;
-  if (!prizeAdjacent) {
-    while (temp) {
-      feasible[temp->name] = -1;
-      temp = temp->next;
-    }
-  } else {
-    while (temp) {
-      (feasible[temp->name] != -1) ? ++feasible[temp->name] : feasible[temp->name];
-      temp = temp->next;
+  for (i = 0; i < g->vertices; ++i) {
+    reverse->offsets[i + 1] += reverse->offsets[i];
+  }
+
+  size_t *cursor = malloc((g->vertices ? g->vertices : 1) * sizeof(*cursor));
+  memcpy(cursor, reverse->offsets, g->vertices * sizeof(*cursor));
+  for (i = 0; i < g->vertices; ++i) {
+    size_t j = g->offsets[i];
+    for (; j < g->ends[i]; ++j) {
+      reverse->neighbors[cursor[g->neighbors[j]]++] = (int)i;
     }
   }
-  prizeAdjacent ? fputs("Adjacent", stdout) : fputs("Not adjacent", stdout);
-  free(temp);
+
+  free(cursor);
+  return reverse;
 }
 
 /**
- * Searches the graph vertices and prints possible `prize` candidates in each loop. 
- * Prechecks if a vertex's neighbors are all handled and known to be not `prize`, then skips that node.
- * 
- * @param g Pointer to graph object to be searched.
- * @param feasible Array that lists all vertices' being `prize` vertex probability.
+ * Computes a new numbering of the vertices that places vertices used together close to each other.
+ * - ORDER_BFS: breadth first order, every unvisited vertex in index order starts a new search.
+ * - ORDER_RCM: reverse Cuthill-McKee, breadth first from the lowest degree unvisited vertex with
+ *   neighbors visited in increasing degree order, the whole order reversed at the end.
+ * - ORDER_DEGREE: decreasing degree, so high degree vertices share the first cache lines.
+ *
+ * @param g Pointer to graph object to be ordered.
+ * @param method One of the `ORDER_` methods.
+ *
+ * @return Newly allocated array where `order[k]` is the vertex that gets number `k`.
  */
-void searchGraph(Graph *g, int prize) {
-  int *feasible = calloc(g->vertices, sizeof(*feasible));
-
-  fputs("Graph:\n", stdout);
-  printGraph(g);
+int *vertexOrder(Graph *g, int method) {
+  size_t n = g->vertices;
+  int *order = malloc((n ? n : 1) * sizeof(*order));
 
+  /* Vertices sorted by degree with a counting sort, ascending for RCM and descending otherwise. */
+  size_t maxDegree = 0;
   size_t i = 0;
-  for (; i < g->vertices; ++i) {  
-   if (!allNeighborsChecked(g->nodes[i], feasible)) {
-     fputs("\nProbable nodes: ", stdout);
-     printNodes(g, feasible);
-     fputc('\n', stdout);
-     fprintf(stdout, "Checking adj for node %llu: ", i);
-     checkAdjacency(g->nodes[i], feasible, prize);
-     fputc('\n', stdout);
-   }
+  for (; i < n; ++i) {
+    size_t degree = g->ends[i] - g->offsets[i];
+    maxDegree = (degree > maxDegree) ? degree : maxDegree;
+  }
+  size_t *start = calloc(maxDegree + 2, sizeof(*start));
+  int *byDegree = malloc((n ? n : 1) * sizeof(*byDegree));
+  for (i = 0; i < n; ++i) {
+    size_t degree = g->ends[i] - g->offsets[i];
+    ++start[(method == ORDER_RCM ? degree : maxDegree - degree) + 1];
   }
+  for (i = 0; i <= maxDegree; ++i) {
+    start[i + 1] += start[i];
+  }
+  for (i = 0; i < n; ++i) {
+    size_t degree = g->ends[i] - g->offsets[i];
+    byDegree[start[method == ORDER_RCM ? degree : maxDegree - degree]++] = (int)i;
+  }
+  free(start);
 
-  fputs("\nChosen node is in: ", stdout);
-  printMostFeasible(g, feasible);
+  if (method == ORDER_DEGREE) {
+    free(order);
+    return byDegree;
+  }
+
+  int *rank = NULL;
+  if (method == ORDER_RCM) {
+    rank = malloc((n ? n : 1) * sizeof(*rank));
+    for (i = 0; i < n; ++i) {
+      rank[byDegree[i]] = (int)i;
+    }
+  }
+
+  /* Breadth first search, `order` itself is the queue. */
+  char *visited = calloc(n ? n : 1, sizeof(*visited));
+  size_t tail = 0;
+  size_t head = 0;
+  size_t s = 0;
+  for (; s < n; ++s) {
+    int root = (method == ORDER_RCM) ? byDegree[s] : (int)s;
+    if (visited[root]) {
+      continue;
+    }
+    visited[root] = 1;
+    order[tail++] = root;
+
+    while (head < tail) {
+      int u = order[head++];
+      size_t first = tail;
+      size_t j = g->offsets[u];
+      for (; j < g->ends[u]; ++j) {
+        int v = g->neighbors[j];
+        if (!visited[v]) {
+          visited[v] = 1;
+          order[tail++] = v;
+        }
+      }
+
+      /*
+       * Cuthill-McKee visits newly found neighbors in increasing degree order. Their places in
+       * `byDegree` are sorted instead of the vertices, so ties keep ascending vertex order.
+       */
+      if (method == ORDER_RCM && tail - first > 1) {
+        size_t a = first;
+        for (; a < tail; ++a) {
+          order[a] = rank[order[a]];
+        }
+        qsort(order + first, tail - first, sizeof(*order), compareInts);
+        for (a = first; a < tail; ++a) {
+          order[a] = byDegree[order[a]];
+        }
+      }
+    }
+  }
+
+  if (method == ORDER_RCM) {
+    for (i = 0; i < n / 2; ++i) {
+      int temp = order[i];
+      order[i] = order[n - 1 - i];
+      order[n - 1 - i] = temp;
+    }
+  }
+
+  free(visited);
+  free(rank);
+  free(byDegree);
+  return order;
 }
 
 /**
- * Frees the graph and all the pointers to vertices inside.
- * 
- * @param g Pointer to graph object to be freed.
+ * Creates a copy of a graph with vertices renumbered by `vertexOrder`. The copy keeps the input
+ * name of every vertex, see `vertexName` and `vertexId`.
+ *
+ * @param g Pointer to graph object to be renumbered.
+ * @param method One of the `ORDER_` methods.
+ *
+ * @return Pointer to newly created Graph object.
  */
-void freeGraph(Graph *g) {
-  if (!g) {
-    return;
-  }
+Graph *reorderGraph(Graph *g, int method) {
+  int *order = vertexOrder(g, method);
+  int *ids = malloc((g->vertices ? g->vertices : 1) * sizeof(*ids));
 
   size_t i = 0;
   for (; i < g->vertices; ++i) {
-    GraphNode *node = g->nodes[i];
-    while (node) {
-      GraphNode *temp = node;
-      node = node->next;
-      free(temp);
+    ids[order[i]] = (int)i;
+  }
+
+  GraphBuilder *builder = createGraphBuilder(g->vertices);
+  for (i = 0; i < g->vertices; ++i) {
+    size_t j = g->offsets[i];
+    for (; j < g->ends[i]; ++j) {
+      collectEdge(builder, ids[i], ids[g->neighbors[j]]);
     }
   }
+  Graph *ordered = buildGraph(builder);
 
-  free(g->nodes);
-  free(g);
+  /* Renumbering an already renumbered graph composes the names. */
+  for (i = 0; i < g->vertices; ++i) {
+    order[i] = vertexName(g, order[i]);
+    ids[order[i]] = (int)i;
+  }
+  ordered->names = order;
+  ordered->ids = ids;
+
+  return ordered;
 }
 
 /**
- * Creates a graph structure with edge relations read from a file input.
- * 
- * @param file_name Name of the file to be read.
- * 
- * @return Pointer to newly created Graph object.
+ * Returns the input name of a vertex.
+ *
+ * @param g Pointer to graph object that holds the vertex.
+ * @param v Vertex number inside the graph.
+ *
+ * @return Name of the vertex in the input file.
  */
-Graph *readInput(char *file_name) {
-  FILE *fp = fopen(file_name, "r");
+int vertexName(Graph *g, size_t v) {
+  return g->names ? g->names[v] : (int)v;
+}
 
-  size_t vertices;
-  fscanf(fp, "%llu", &vertices);
-  fgetc(fp);
+/**
+ * Returns the vertex number of an input name.
+ *
+ * @param g Pointer to graph object that holds the vertex.
+ * @param name Name of the vertex in the input file.
+ *
+ * @return Vertex number inside the graph.
+ */
+int vertexId(Graph *g, int name) {
+  return g->ids ? g->ids[name] : name;
+}
 
-  Graph *graph = createGraph(vertices);
+#if !defined(__GNUC__) && !defined(__clang__)
+/**
+ * Portable fallback for counting trailing zero bits of a non-zero word.
+ *
+ * @param word Word to be checked, must not be 0.
+ *
+ * @return Index of the lowest set bit.
+ */
+int countTrailingZeros(uint64_t word) {
+  int count = 0;
+  while (!(word & 1)) {
+    word >>= 1;
+    ++count;
+  }
+  return count;
+}
 
-  size_t i = 0;
-  for (; i < vertices; ++i) {
-    char *line = calloc(5 * vertices, sizeof(*line));
-    int *numbers = calloc(vertices, sizeof(*numbers));
-    size_t count = 0;
+/**
+ * Portable fallback for counting set bits of a word.
+ *
+ * @param word Word to be counted.
+ *
+ * @return Number of set bits.
+ */
+int popCount(uint64_t word) {
+  int count = 0;
+  while (word) {
+    word &= word - 1;
+    ++count;
+  }
+  return count;
+}
+#endif
 
-    fgets(line, 5 * vertices, fp);
-    char *token = strtok(line, " \n\t");
-    while (token) {
-      numbers[count++] = atoi(token);
-      token = strtok(NULL, " \n\t");
-    }
+/**
+ * Creates a bitset with given bit count.
+ *
+ * @param bits Number of bits in the set.
+ * @param filled True to start with every bit set, false to start empty.
+ *
+ * @return Pointer to newly created Bitset object.
+ */
+Bitset *createBitset(size_t bits, int filled) {
+  Bitset *set = malloc(sizeof(*set));
+  set->bits = bits;
+  set->words = (bits + WORD_BITS - 1) / WORD_BITS;
+  set->data = malloc((set->words ? set->words : 1) * sizeof(*set->data));
+  fillBitset(set, filled);
 
-    size_t j;
-    for (j = 0; j < count; ++j) {
-      addEdge(graph, numbers[0], numbers[j]);
-    }
+  return set;
+}
+
+/**
+ * Sets or clears every bit of a bitset.
+ *
+ * @param set Bitset to be filled.
+ * @param filled True to set every bit, false to clear every bit.
+ */
+void fillBitset(Bitset *set, int filled) {
+  memset(set->data, filled ? 0xFF : 0, set->words * sizeof(*set->data));
 
-    free(line);
-    free(numbers);
+  /* Bits past `bits` in the last word are kept clear so word scans never report them. */
+  if (filled && set->bits % WORD_BITS) {
+    set->data[set->words - 1] = (UINT64_C(1) << (set->bits % WORD_BITS)) - 1;
   }
+}
 
-  fclose(fp);
-  return graph;
+/**
+ * Frees a bitset and its words.
+ *
+ * @param set Pointer to bitset object to be freed.
+ */
+void freeBitset(Bitset *set) {
+  if (!set) {
+    return;
+  }
+
+  free(set->data);
+  free(set);
+}
+
+/**
+ * Creates the candidate state of a search where every vertex may be the `prize` vertex.
+ *
+ * @param vertices Vertex count of the searched graph.
+ *
+ * @return Pointer to newly created SearchState object.
+ */
+SearchState *createSearchState(size_t vertices) {
+  SearchState *state = malloc(sizeof(*state));
+  state->alive = createBitset(vertices, 1);
+  state->best = createBitset(vertices, 1);
+  state->scratch = createBitset(vertices, 0);
+  state->adjacentAnswers = 0;
+  state->candidates = vertices;
+  state->answers = NULL;
+  state->noHits = NULL;
+  state->yesHits = NULL;
+  state->distance = NULL;
+
+  return state;
+}
+
+/**
+ * Resets a search state so it can be reused for a new search on the same graph.
+ *
+ * @param state Search state to be reset.
+ */
+void resetSearchState(SearchState *state) {
+  fillBitset(state->alive, 1);
+  fillBitset(state->best, 1);
+  state->adjacentAnswers = 0;
+  state->candidates = state->alive->bits;
+  if (state->distance) {
+    state->distance->reachCandidates = 0;
+  }
+
+  if (state->answers) {
+    size_t n = state->alive->bits;
+    memset(state->answers, ANSWER_NONE, n * sizeof(*state->answers));
+    memset(state->noHits, 0, n * sizeof(*state->noHits));
+    memset(state->yesHits, 0, n * sizeof(*state->yesHits));
+  }
+}
+
+/**
+ * Starts keeping every answer of a search, so `updateCandidates` can correct the candidates after
+ * edge updates. Must be called before the first question, only adjacency answers are kept.
+ *
+ * @param state Fresh or reset search state.
+ */
+void trackAnswers(SearchState *state) {
+  size_t n = state->alive->bits ? state->alive->bits : 1;
+  state->answers = calloc(n, sizeof(*state->answers));
+  state->noHits = calloc(n, sizeof(*state->noHits));
+  state->yesHits = calloc(n, sizeof(*state->yesHits));
+}
+
+/**
+ * Takes back the kept answer of a vertex, as if it was never asked. Forgetting an "Adjacent" answer
+ * changes what every vertex needs to be in `best`, so that case rebuilds `best` from the counts.
+ *
+ * @param g Pointer to graph object that holds the vertex.
+ * @param state Search state with kept answers.
+ * @param vertex Vertex whose answer is taken back.
+ */
+void forgetAnswer(Graph *g, SearchState *state, size_t vertex) {
+  uint64_t *alive = state->alive->data;
+  uint64_t *best = state->best->data;
+  char answer = state->answers[vertex];
+  state->answers[vertex] = ANSWER_NONE;
+
+  size_t j = g->offsets[vertex];
+  for (; j < g->ends[vertex]; ++j) {
+    int v = g->neighbors[j];
+    if (answer == ANSWER_NO && --state->noHits[v] == 0) {
+      alive[v / WORD_BITS] |= UINT64_C(1) << (v % WORD_BITS);
+    } else if (answer == ANSWER_YES) {
+      --state->yesHits[v];
+    }
+  }
+
+  if (answer == ANSWER_YES) {
+    --state->adjacentAnswers;
+    size_t v = 0;
+    for (; v < state->best->bits; ++v) {
+      if (state->yesHits[v] == state->adjacentAnswers) {
+        best[v / WORD_BITS] |= UINT64_C(1) << (v % WORD_BITS);
+      } else {
+        best[v / WORD_BITS] &= ~(UINT64_C(1) << (v % WORD_BITS));
+      }
+    }
+  }
+
+  size_t candidates = 0;
+  size_t w = 0;
+  for (; w < state->alive->words; ++w) {
+    candidates += popCount(state->adjacentAnswers ? alive[w] & best[w] : alive[w]);
+  }
+  state->candidates = candidates;
+}
+
+/**
+ * Corrects the candidates of a search with kept answers after the edge `u -> v` was added or removed.
+ * Only `v` can change: its count of "Not adjacent" or "Adjacent" neighbor sets moves by one if `u`
+ * was asked. Answers are kept as they were given, so an update between an asked vertex and the
+ * `prize` itself makes that answer stale; asking the vertex again replaces it.
+ *
+ * @param state Search state with kept answers.
+ * @param u, v Vertices around the updated edge.
+ * @param added True if the edge was added, false if it was removed.
+ */
+void updateCandidates(SearchState *state, int u, int v, int added) {
+  if (!state->answers || state->answers[u] == ANSWER_NONE) {
+    return;
+  }
+
+  uint64_t bit = UINT64_C(1) << (v % WORD_BITS);
+  int wasCandidate = isCandidate(state, v);
+
+  if (state->answers[u] == ANSWER_NO) {
+    state->noHits[v] += added ? 1 : -1;
+    if (state->noHits[v] == 0) {
+      state->alive->data[v / WORD_BITS] |= bit;
+    } else {
+      state->alive->data[v / WORD_BITS] &= ~bit;
+    }
+  } else {
+    state->yesHits[v] += added ? 1 : -1;
+    if (state->yesHits[v] == state->adjacentAnswers) {
+      state->best->data[v / WORD_BITS] |= bit;
+    } else {
+      state->best->data[v / WORD_BITS] &= ~bit;
+    }
+  }
+
+  state->candidates += isCandidate(state, v) - wasCandidate;
+}
+
+/**
+ * Frees a search state and its bitsets.
+ *
+ * @param state Pointer to search state object to be freed.
+ */
+void freeSearchState(SearchState *state) {
+  if (!state) {
+    return;
+  }
+
+  freeBitset(state->alive);
+  freeBitset(state->best);
+  freeBitset(state->scratch);
+  free(state->answers);
+  free(state->noHits);
+  free(state->yesHits);
+  free(state);
+}
+
+/**
+ * Prints the graph with all its vertices and adjacent vertices to it. 
+ * 
+ * @param g Pointer to the graph object to be printed.
+ */
+void printGraph(Graph *g) {
+  size_t i = 0;
+  for (; i < g->vertices; ++i) {
+    fprintf(stdout, "%d: ", vertexName(g, i));
+    size_t j = g->offsets[i];
+    for (; j < g->ends[i]; ++j) {
+      fprintf(stdout, "%d -> ", vertexName(g, g->neighbors[j]));
+    }
+    fputs("NULL\n", stdout);
+  }
+}
+
+/**
+ * Prints the names of vertices set in `set`, or in `set & mask` if a mask is given.
+ * Words are scanned whole and only set bits are visited.
+ *
+ * @param g Pointer to the graph object the bits stand for.
+ * @param set Bitset to be printed.
+ * @param mask Bitset to be intersected with `set`, may be NULL.
+ */
+void printBits(Graph *g, Bitset *set, Bitset *mask) {
+  size_t w = 0;
+  for (; w < set->words; ++w) {
+    uint64_t word = mask ? set->data[w] & mask->data[w] : set->data[w];
+    while (word) {
+      fprintf(stdout, "%d ", vertexName(g, w * WORD_BITS + countTrailingZeros(word)));
+      word &= word - 1;
+    }
+  }
+}
+
+/**
+ * Prints vertices of a graph that are possible `prize` vertices.
+ * 
+ * @param g Pointer to the graph object to be printed.
+ * @param state Candidate state of the search.
+ */
+void printNodes(Graph *g, SearchState *state) {
+  printBits(g, state->alive, NULL);
+}
+
+/**
+ * Out of feasible list, prints the vertices with the most probability. It may be more than one vertex.
+ * Those are the vertices inside every "Adjacent" answer that no "Not adjacent" answer ruled out.
+ * 
+ * @param g Pointer to the graph object to be printed.
+ * @param state Candidate state of the search.
+ */
+void printMostFeasible(Graph *g, SearchState *state) {
+  printBits(g, state->alive, state->adjacentAnswers ? state->best : NULL);
+}
+
+/**
+ * Checks if a vertex is still among the most feasible `prize` vertices.
+ *
+ * @param state Candidate state of the search.
+ * @param v Vertex to be checked.
+ *
+ * @return True if `v` is a candidate, false if not.
+ */
+int isCandidate(SearchState *state, int v) {
+  uint64_t bit = UINT64_C(1) << (v % WORD_BITS);
+  if (!(state->alive->data[v / WORD_BITS] & bit)) {
+    return 0;
+  }
+  return !state->adjacentAnswers || (state->best->data[v / WORD_BITS] & bit);
+}
+
+/**
+ * Checks and returns true if a vertex's adjacent vertices' are all non-feasible for being the `prize` vertex.
+ * 
+ * @param g Pointer to graph object that holds the vertex.
+ * @param vertex Vertex to be checked.
+ * @param state Candidate state of the search.
+ * 
+ * @return True if all non-feasible, false if not.
+ */
+int allNeighborsChecked(Graph *g, size_t vertex, SearchState *state) {
+  const uint64_t *alive = state->alive->data;
+  size_t j = g->offsets[vertex];
+  for (; j < g->ends[vertex]; ++j) {
+    int v = g->neighbors[j];
+    if (alive[v / WORD_BITS] & (UINT64_C(1) << (v % WORD_BITS))) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/**
+ * Binary searches the sorted adjacency list of a vertex.
+ *
+ * @param g Pointer to graph object that holds the vertex.
+ * @param vertex Vertex whose neighbors are searched.
+ * @param name Name of the node to be found.
+ *
+ * @return Position of the first neighbor not less than `name`, `g->ends[vertex]` if there is none.
+ */
+size_t findNeighbor(Graph *g, size_t vertex, int name) {
+  size_t low = g->offsets[vertex];
+  size_t high = g->ends[vertex];
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (g->neighbors[mid] < name) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+/**
+ * Checks if a vertex is adjacent to a node.
+ *
+ * @param g Pointer to graph object that holds the vertex.
+ * @param vertex Vertex whose neighbors are searched.
+ * @param name Name of the node to be found.
+ *
+ * @return True if `name` is adjacent to `vertex`, false if not.
+ */
+int isNeighbor(Graph *g, size_t vertex, int name) {
+  size_t at = findNeighbor(g, vertex, name);
+  return at < g->ends[vertex] && g->neighbors[at] == name;
+}
+
+/**
+ * Asks if a vertex is a neighbor to `prize` node and updates the feasibleness of its adjacent vertices.
+ * 
+ * @param[in] g Pointer to graph object that holds the vertex.
+ * @param[in] vertex Vertex to be checked.
+ * @param[out] state Candidate state of the search.
+ * @param[in] prize Name of the `prize` node.
+ *
+ * @return True if the vertex is adjacent to `prize`, false if not.
+ */
+int checkAdjacency(Graph *g, size_t vertex, SearchState *state, int prize) {
+  const int *begin = g->neighbors + g->offsets[vertex];
+  const int *end = g->neighbors + g->ends[vertex];
+  const int *temp;
+
+  int prizeAdjacent = isNeighbor(g, vertex, prize);
+
+  /* Kept answers count every neighbor set a vertex is in, asking again replaces the old answer. */
+  if (state->answers) {
+    if (state->answers[vertex] != ANSWER_NONE) {
+      forgetAnswer(g, state, vertex);
+    }
+    state->answers[vertex] = prizeAdjacent ? ANSWER_YES : ANSWER_NO;
+    for (temp = begin; temp < end; ++temp) {
+      prizeAdjacent ? ++state->yesHits[*temp] : ++state->noHits[*temp];
+    }
+  }
+
+  narrowByList(state, begin, end, prizeAdjacent);
+  return prizeAdjacent;
+}
+
+/**
+ * Narrows the candidates down with the answer for a set of vertices given as a list.
+ * If the `prize` is not inside, none of them can be the `prize` node, they are cleared from `alive`.
+ * If it is inside, the `prize` node is one of them, so `best` is masked with the set.
+ *
+ * @param state Candidate state of the search.
+ * @param begin, end Vertices of the set, without repeats.
+ * @param inside True if the `prize` is in the set, false if not.
+ */
+void narrowByList(SearchState *state, const int *begin, const int *end, int inside) {
+  const int *temp;
+
+  if (!inside) {
+    uint64_t *alive = state->alive->data;
+    for (temp = begin; temp < end; ++temp) {
+      if (isCandidate(state, *temp)) {
+        --state->candidates;
+      }
+      alive[*temp / WORD_BITS] &= ~(UINT64_C(1) << (*temp % WORD_BITS));
+    }
+  } else {
+    uint64_t *mask = state->scratch->data;
+    for (temp = begin; temp < end; ++temp) {
+      mask[*temp / WORD_BITS] |= UINT64_C(1) << (*temp % WORD_BITS);
+    }
+
+    narrowBySet(state, state->scratch, 1);
+
+    /* Only the words touched above need clearing for the next use. */
+    for (temp = begin; temp < end; ++temp) {
+      mask[*temp / WORD_BITS] = 0;
+    }
+  }
+}
+
+/**
+ * Narrows the candidates down with the answer for a set of vertices given as a bitset, see `narrowByList`.
+ *
+ * @param state Candidate state of the search.
+ * @param set Vertices of the set.
+ * @param inside True if the `prize` is in the set, false if not.
+ */
+void narrowBySet(SearchState *state, const Bitset *set, int inside) {
+  uint64_t *alive = state->alive->data;
+  uint64_t *best = state->best->data;
+  const uint64_t *bits = set->data;
+  if (inside) {
+    ++state->adjacentAnswers;
+  }
+
+  /* Word-parallel AND with popcount, plain enough for the compiler to vectorize. */
+  size_t candidates = 0;
+  size_t w = 0;
+  if (inside) {
+    for (; w < state->best->words; ++w) {
+      best[w] &= bits[w];
+      candidates += popCount(best[w] & alive[w]);
+    }
+  } else {
+    for (; w < state->alive->words; ++w) {
+      alive[w] &= ~bits[w];
+      candidates += popCount(state->adjacentAnswers ? alive[w] & best[w] : alive[w]);
+    }
+  }
+  state->candidates = candidates;
+}
+
+/**
+ * Creates a breadth-first search that collects balls of given radius.
+ *
+ * @param g Pointer to graph object to be searched.
+ * @param reverse Reverse of `g` for bottom-up levels, see `transposeGraph`. May be NULL, not freed with the search.
+ * @param radius Most steps a vertex of the ball may be away from the sources.
+ *
+ * @return Pointer to newly created BallSearch object.
+ */
+BallSearch *createBallSearch(Graph *g, Graph *reverse, size_t radius) {
+  BallSearch *b = malloc(sizeof(*b));
+  b->g = g;
+  b->reverse = reverse;
+  b->radius = radius;
+  b->ball = createBitset(g->vertices, 0);
+  b->frontier = createBitset(g->vertices, 0);
+  b->next = createBitset(g->vertices, 0);
+  b->members = malloc((g->vertices ? g->vertices : 1) * sizeof(*b->members));
+  b->count = 0;
+  b->size = 0;
+  b->sparse = 1;
+
+  return b;
+}
+
+/**
+ * Frees a ball search, except the graphs it was given.
+ *
+ * @param b Pointer to ball search object to be freed.
+ */
+void freeBallSearch(BallSearch *b) {
+  if (!b) {
+    return;
+  }
+
+  freeBitset(b->ball);
+  freeBitset(b->frontier);
+  freeBitset(b->next);
+  free(b->members);
+  free(b);
+}
+
+/**
+ * Empties the ball of the previous search. A listed ball only clears its own bits.
+ *
+ * @param b Pointer to ball search object.
+ */
+void clearBall(BallSearch *b) {
+  if (b->sparse) {
+    size_t i = 0;
+    for (; i < b->count; ++i) {
+      b->ball->data[b->members[i] / WORD_BITS] = 0;
+    }
+  } else {
+    fillBitset(b->ball, 0);
+  }
+
+  b->count = 0;
+  b->size = 0;
+  b->sparse = 1;
+}
+
+/**
+ * Collects every vertex within `radius` steps of any source into `b->ball`. A source is only in the
+ * ball if another source or itself leads back to it. Each level runs top-down or bottom-up, whichever
+ * is expected to look at fewer edges.
+ *
+ * @param b Pointer to ball search object.
+ * @param sources Vertices to start from, without repeats.
+ * @param count Number of vertices in `sources`.
+ *
+ * @return Number of vertices in the ball.
+ */
+size_t growBall(BallSearch *b, const int *sources, size_t count) {
+  Graph *g = b->g;
+  clearBall(b);
+
+  const int *frontier = sources;
+  size_t frontierSize = count;
+  size_t frontierEdges = 0;
+  size_t i = 0;
+  for (; i < count; ++i) {
+    frontierEdges += g->ends[sources[i]] - g->offsets[sources[i]];
+  }
+
+  size_t unexplored = g->edges;
+  int bottomUp = 0;
+  size_t level = 0;
+  for (; level < b->radius && frontierSize; ++level) {
+    if (!bottomUp && b->reverse && frontierEdges > unexplored / SWITCH_ALPHA) {
+      for (i = 0; i < frontierSize; ++i) {
+        b->frontier->data[frontier[i] / WORD_BITS] |= UINT64_C(1) << (frontier[i] % WORD_BITS);
+      }
+      bottomUp = 1;
+      b->sparse = 0;
+    } else if (bottomUp && frontierSize < g->vertices / SWITCH_BETA) {
+      b->count = 0;
+      size_t w = 0;
+      for (; w < b->frontier->words; ++w) {
+        uint64_t word = b->frontier->data[w];
+        while (word) {
+          b->members[b->count++] = (int)(w * WORD_BITS + countTrailingZeros(word));
+          word &= word - 1;
+        }
+        b->frontier->data[w] = 0;
+      }
+      frontier = b->members;
+      bottomUp = 0;
+    }
+
+    if (bottomUp) {
+      frontierEdges = expandBottomUp(b, &frontierSize);
+    } else {
+      size_t start = b->count;
+      frontierEdges = expandTopDown(b, frontier, frontierSize);
+      frontier = b->members + start;
+      frontierSize = b->count - start;
+    }
+    b->size += frontierSize;
+    unexplored = (unexplored > frontierEdges) ? unexplored - frontierEdges : 0;
+  }
+
+  if (bottomUp) {
+    fillBitset(b->frontier, 0);
+  }
+  return b->size;
+}
+
+/**
+ * Runs one top-down level: every edge out of the frontier list is followed, new vertices are listed
+ * after `b->count` and set in the ball.
+ *
+ * @param b Pointer to ball search object.
+ * @param frontier Vertices reached on the previous level.
+ * @param size Number of vertices in `frontier`.
+ *
+ * @return Number of edges out of the new vertices.
+ */
+size_t expandTopDown(BallSearch *b, const int *frontier, size_t size) {
+  Graph *g = b->g;
+  uint64_t *ball = b->ball->data;
+  size_t edges = 0;
+  size_t i = 0;
+  for (; i < size; ++i) {
+    size_t j = g->offsets[frontier[i]];
+    for (; j < g->ends[frontier[i]]; ++j) {
+      int v = g->neighbors[j];
+      uint64_t bit = UINT64_C(1) << (v % WORD_BITS);
+      if (!(ball[v / WORD_BITS] & bit)) {
+        ball[v / WORD_BITS] |= bit;
+        b->members[b->count++] = v;
+        edges += g->ends[v] - g->offsets[v];
+      }
+    }
+  }
+  return edges;
+}
+
+/**
+ * Runs one bottom-up level: every vertex outside the ball looks for a frontier vertex among its
+ * reverse neighbors and stops at the first one. The new vertices become the frontier bitset.
+ *
+ * @param b Pointer to ball search object with a reverse graph.
+ * @param[out] size Number of new vertices.
+ *
+ * @return Number of edges out of the new vertices.
+ */
+size_t expandBottomUp(BallSearch *b, size_t *size) {
+  Graph *g = b->g;
+  Graph *reverse = b->reverse;
+  uint64_t *ball = b->ball->data;
+  const uint64_t *frontier = b->frontier->data;
+  uint64_t *next = b->next->data;
+  size_t found = 0;
+  size_t edges = 0;
+
+  size_t w = 0;
+  for (; w < b->ball->words; ++w) {
+    uint64_t open = ~ball[w];
+    if (w == b->ball->words - 1 && b->ball->bits % WORD_BITS) {
+      open &= (UINT64_C(1) << (b->ball->bits % WORD_BITS)) - 1;
+    }
+    while (open) {
+      size_t v = w * WORD_BITS + countTrailingZeros(open);
+      open &= open - 1;
+
+      size_t j = reverse->offsets[v];
+      for (; j < reverse->ends[v]; ++j) {
+        int u = reverse->neighbors[j];
+        if (frontier[u / WORD_BITS] & (UINT64_C(1) << (u % WORD_BITS))) {
+          next[w] |= UINT64_C(1) << (v % WORD_BITS);
+          ++found;
+          edges += g->ends[v] - g->offsets[v];
+          break;
+        }
+      }
+    }
+  }
+
+  /* New vertices join the ball and become the frontier, the old frontier words are reused as `next`. */
+  Bitset *old = b->frontier;
+  for (w = 0; w < b->ball->words; ++w) {
+    ball[w] |= next[w];
+    old->data[w] = 0;
+  }
+  b->frontier = b->next;
+  b->next = old;
+
+  *size = found;
+  return edges;
+}
+
+/**
+ * Creates the engine of distance questions for a graph.
+ *
+ * @param g Pointer to graph object to be searched.
+ * @param reverse Reverse of `g`, see `transposeGraph`. Not freed with the engine.
+ * @param radius Most steps the `prize` may be away from an asked vertex for a "Within" answer.
+ *
+ * @return Pointer to newly created DistanceQuery object.
+ */
+DistanceQuery *createDistanceQuery(Graph *g, Graph *reverse, size_t radius) {
+  DistanceQuery *d = malloc(sizeof(*d));
+  d->forward = createBallSearch(g, reverse, radius);
+  d->backward = createBallSearch(reverse, g, radius);
+  d->sources = malloc((g->vertices ? g->vertices : 1) * sizeof(*d->sources));
+  d->reachCandidates = 0;
+
+  return d;
+}
+
+/**
+ * Frees the engine of distance questions, except the graphs it was given.
+ *
+ * @param d Pointer to distance query object to be freed.
+ */
+void freeDistanceQuery(DistanceQuery *d) {
+  if (!d) {
+    return;
+  }
+
+  freeBallSearch(d->forward);
+  freeBallSearch(d->backward);
+  free(d->sources);
+  free(d);
+}
+
+/**
+ * Checks if a vertex can still reach a candidate within the radius, since only then its answer
+ * could change anything. The vertices that can are found with one search from all candidates over
+ * the reverse graph, repeated whenever the candidates halve; until then every vertex counts.
+ *
+ * @param vertex Vertex to be checked.
+ * @param state Candidate state of a distance search.
+ *
+ * @return True if the vertex may reach a candidate, false if it surely does not.
+ */
+int canReachCandidate(size_t vertex, SearchState *state) {
+  DistanceQuery *d = state->distance;
+  size_t last = d->reachCandidates ? d->reachCandidates : state->alive->bits;
+
+  if (state->candidates * 2 <= last) {
+    size_t count = 0;
+    size_t w = 0;
+    for (; w < state->alive->words; ++w) {
+      uint64_t word = state->alive->data[w];
+      if (state->adjacentAnswers) {
+        word &= state->best->data[w];
+      }
+      while (word) {
+        d->sources[count++] = (int)(w * WORD_BITS + countTrailingZeros(word));
+        word &= word - 1;
+      }
+    }
+    growBall(d->backward, d->sources, count);
+    d->reachCandidates = state->candidates ? state->candidates : 1;
+  }
+
+  if (!d->reachCandidates) {
+    return 1;
+  }
+  return (d->backward->ball->data[vertex / WORD_BITS] >> (vertex % WORD_BITS)) & 1;
+}
+
+/**
+ * Asks if the `prize` node is within the radius of a vertex and updates the feasibleness of every
+ * vertex in that ball, the same way `checkAdjacency` does for neighbors.
+ *
+ * @param[in] vertex Vertex to be checked.
+ * @param[out] state Candidate state of a distance search.
+ * @param[in] prize Name of the `prize` node.
+ *
+ * @return True if `prize` is within the radius of the vertex, false if not.
+ */
+int checkDistance(size_t vertex, SearchState *state, int prize) {
+  BallSearch *b = state->distance->forward;
+  int source = (int)vertex;
+  growBall(b, &source, 1);
+
+  int within = (b->ball->data[prize / WORD_BITS] >> (prize % WORD_BITS)) & 1;
+  if (b->sparse) {
+    narrowByList(state, b->members, b->members + b->count, within);
+  } else {
+    narrowBySet(state, b->ball, within);
+  }
+  return within;
+}
+
+/**
+ * Strategy that asks about vertices in index order. Skips a vertex if its neighbors are all handled
+ * and known to be not `prize`, since its answer could not change anything. For distance questions,
+ * skips a vertex that cannot reach a candidate instead.
+ *
+ * @param g Pointer to graph object to be searched.
+ * @param state Candidate state of the search.
+ * @param context Pointer to the next vertex index to look at, starting from 0.
+ *
+ * @return Next vertex to ask about, `g->vertices` if none is left.
+ */
+size_t sequentialStrategy(Graph *g, SearchState *state, void *context) {
+  size_t *cursor = context;
+  while (*cursor < g->vertices &&
+         (state->distance ? !canReachCandidate(*cursor, state) : allNeighborsChecked(g, *cursor, state))) {
+    ++(*cursor);
+  }
+  return (*cursor < g->vertices) ? (*cursor)++ : g->vertices;
+}
+
+/**
+ * Creates the context of the greedy strategy for a new search. Scores are computed on the first pick.
+ *
+ * @param g Pointer to graph object to be searched.
+ * @param reverse Reverse of `g`, see `transposeGraph`. Not freed with the context.
+ *
+ * @return Pointer to newly created GreedyContext object.
+ */
+GreedyContext *createGreedyContext(Graph *g, Graph *reverse) {
+  GreedyContext *ctx = malloc(sizeof(*ctx));
+  size_t n = g->vertices ? g->vertices : 1;
+
+  ctx->reverse = reverse;
+  ctx->known = createBitset(g->vertices, 0);
+  ctx->score = malloc(n * sizeof(*ctx->score));
+  ctx->next = malloc(n * sizeof(*ctx->next));
+  ctx->prev = malloc(n * sizeof(*ctx->prev));
+
+  /* No vertex has more candidate neighbors than neighbors. */
+  ctx->maxScore = 0;
+  size_t i = 0;
+  for (; i < g->vertices; ++i) {
+    size_t degree = g->ends[i] - g->offsets[i];
+    ctx->maxScore = (degree > ctx->maxScore) ? degree : ctx->maxScore;
+  }
+  ctx->bucketHead = malloc((ctx->maxScore + 1) * sizeof(*ctx->bucketHead));
+  resetGreedyContext(ctx);
+
+  return ctx;
+}
+
+/**
+ * Resets the greedy strategy context for a new search, scores are recomputed on the next pick.
+ * Also needed after edge updates, with every update applied to the reverse graph as well.
+ *
+ * @param ctx Pointer to context object to be reset.
+ */
+void resetGreedyContext(GreedyContext *ctx) {
+  ctx->top = 0;
+  ctx->lastPick = ctx->reverse->vertices;
+  ctx->lastAdjacentAnswers = 0;
+}
+
+/**
+ * Frees the greedy strategy context, except the reverse graph it was given.
+ *
+ * @param ctx Pointer to context object to be freed.
+ */
+void freeGreedyContext(GreedyContext *ctx) {
+  if (!ctx) {
+    return;
+  }
+
+  freeBitset(ctx->known);
+  free(ctx->score);
+  free(ctx->bucketHead);
+  free(ctx->next);
+  free(ctx->prev);
+  free(ctx);
+}
+
+/**
+ * Unlinks a vertex from its score bucket and links it into the bucket of a new score.
+ *
+ * @param ctx Pointer to greedy strategy context.
+ * @param q Vertex to be moved.
+ * @param score New score of the vertex.
+ */
+void moveToBucket(GreedyContext *ctx, size_t q, size_t score) {
+  size_t end = ctx->reverse->vertices;
+
+  if (ctx->prev[q] < end) {
+    ctx->next[ctx->prev[q]] = ctx->next[q];
+  } else {
+    ctx->bucketHead[ctx->score[q]] = ctx->next[q];
+  }
+  if (ctx->next[q] < end) {
+    ctx->prev[ctx->next[q]] = ctx->prev[q];
+  }
+
+  ctx->score[q] = score;
+  ctx->prev[q] = end;
+  ctx->next[q] = ctx->bucketHead[score];
+  if (ctx->next[q] < end) {
+    ctx->prev[ctx->next[q]] = q;
+  }
+  ctx->bucketHead[score] = q;
+}
+
+/**
+ * Recomputes every score from the current candidates and relinks all buckets. Cheaper than lowering
+ * scores one by one when most candidates were ruled out at once, which is what "Adjacent" answers do.
+ *
+ * @param ctx Pointer to greedy strategy context.
+ * @param state Candidate state of the search.
+ */
+void rebuildScores(GreedyContext *ctx, SearchState *state) {
+  Graph *reverse = ctx->reverse;
+  size_t end = reverse->vertices;
+
+  memset(ctx->score, 0, end * sizeof(*ctx->score));
+
+  size_t w = 0;
+  for (; w < ctx->known->words; ++w) {
+    uint64_t current = state->alive->data[w];
+    if (state->adjacentAnswers) {
+      current &= state->best->data[w];
+    }
+    ctx->known->data[w] = current;
+
+    while (current) {
+      size_t v = w * WORD_BITS + countTrailingZeros(current);
+      current &= current - 1;
+
+      size_t j = reverse->offsets[v];
+      for (; j < reverse->ends[v]; ++j) {
+        ++ctx->score[reverse->neighbors[j]];
+      }
+    }
+  }
+
+  /* Edge updates may have raised the highest possible score. */
+  size_t i = 0;
+  for (; i < end; ++i) {
+    if (ctx->score[i] > ctx->maxScore) {
+      ctx->maxScore = ctx->score[i];
+      ctx->bucketHead = realloc(ctx->bucketHead, (ctx->maxScore + 1) * sizeof(*ctx->bucketHead));
+    }
+  }
+
+  /* `end` marks the end of a bucket list. */
+  for (i = 0; i <= ctx->maxScore; ++i) {
+    ctx->bucketHead[i] = end;
+  }
+  ctx->top = 0;
+  for (i = end; i > 0; --i) {
+    size_t q = i - 1;
+    ctx->prev[q] = end;
+    ctx->next[q] = ctx->bucketHead[ctx->score[q]];
+    if (ctx->next[q] < end) {
+      ctx->prev[ctx->next[q]] = q;
+    }
+    ctx->bucketHead[ctx->score[q]] = q;
+    ctx->top = (ctx->score[q] > ctx->top) ? ctx->score[q] : ctx->top;
+  }
+}
+
+/**
+ * Finds candidates ruled out since the previous pick by comparing a word of the state with `known`,
+ * and lowers the scores of their in-neighbors.
+ *
+ * @param ctx Pointer to greedy strategy context.
+ * @param state Candidate state of the search.
+ * @param w Index of the word to be compared.
+ */
+void updateScores(GreedyContext *ctx, SearchState *state, size_t w) {
+  Graph *reverse = ctx->reverse;
+  uint64_t current = state->alive->data[w];
+  if (state->adjacentAnswers) {
+    current &= state->best->data[w];
+  }
+  uint64_t removed = ctx->known->data[w] & ~current;
+  ctx->known->data[w] = current;
+
+  while (removed) {
+    size_t v = w * WORD_BITS + countTrailingZeros(removed);
+    removed &= removed - 1;
+
+    size_t j = reverse->offsets[v];
+    for (; j < reverse->ends[v]; ++j) {
+      size_t q = reverse->neighbors[j];
+      moveToBucket(ctx, q, ctx->score[q] - 1);
+    }
+  }
+}
+
+/**
+ * Strategy that asks about the vertex whose neighbor set splits the remaining candidates the
+ * most evenly, so either answer rules out as many candidates as possible. Vertices that cannot
+ * split the candidates are never chosen, so the search stops when no question is useful anymore.
+ *
+ * After a "Not adjacent" answer, only the words holding the asked vertex's neighbors can change, so
+ * only those are compared and only in-neighbors of ruled out candidates get their scores lowered.
+ * Scores are rebuilt from scratch on the first pick and after "Adjacent" answers.
+ *
+ * @param g Pointer to graph object to be searched.
+ * @param state Candidate state of the search.
+ * @param context Pointer to a GreedyContext created for this search.
+ *
+ * @return Next vertex to ask about, `g->vertices` if none is left.
+ */
+size_t greedyStrategy(Graph *g, SearchState *state, void *context) {
+  GreedyContext *ctx = context;
+
+  if (ctx->lastPick < g->vertices && ctx->lastAdjacentAnswers == state->adjacentAnswers) {
+    size_t j = g->offsets[ctx->lastPick];
+    for (; j < g->ends[ctx->lastPick]; ++j) {
+      updateScores(ctx, state, g->neighbors[j] / WORD_BITS);
+    }
+  } else {
+    rebuildScores(ctx, state);
+  }
+  ctx->lastAdjacentAnswers = state->adjacentAnswers;
+
+  size_t candidates = state->candidates;
+  while (ctx->top > 0 && ctx->bucketHead[ctx->top] == g->vertices) {
+    --ctx->top;
+  }
+
+  /* While every score is at most half the candidates, the highest score splits the best. */
+  if (ctx->top <= candidates / 2) {
+    ctx->lastPick = ctx->top ? ctx->bucketHead[ctx->top] : g->vertices;
+    return ctx->lastPick;
+  }
+
+  /* Otherwise compare the closest scores below and above the half, a score of `candidates` splits nothing. */
+  size_t below = candidates / 2;
+  while (below > 0 && ctx->bucketHead[below] == g->vertices) {
+    --below;
+  }
+  size_t above = candidates / 2 + 1;
+  while (above < candidates && above <= ctx->top && ctx->bucketHead[above] == g->vertices) {
+    ++above;
+  }
+  if (above < candidates && above <= ctx->top && candidates - above > below) {
+    ctx->lastPick = ctx->bucketHead[above];
+  } else {
+    ctx->lastPick = below ? ctx->bucketHead[below] : g->vertices;
+  }
+  return ctx->lastPick;
+}
+
+/**
+ * Searches the graph vertices and prints possible `prize` candidates in each loop. 
+ * Vertices are asked about in the order `strategy` picks them, until one candidate remains or
+ * `strategy` has no vertex left to ask about.
+ * 
+ * @param g Pointer to graph object to be searched.
+ * @param prize Name of the `prize` node.
+ * @param strategy Function that picks the next vertex to ask about.
+ * @param context Pointer to context data of `strategy`.
+ * @param distance Engine to ask distance questions with, NULL to ask adjacency questions.
+ *
+ * @return Number of questions asked.
+ */
+size_t searchGraph(Graph *g, int prize, QueryStrategy strategy, void *context, DistanceQuery *distance) {
+  SearchState *state = createSearchState(g->vertices);
+  state->distance = distance;
+  resetSearchState(state);
+
+  fputs("Graph:\n", stdout);
+  printGraph(g);
+
+  size_t questions = resolvePrize(g, state, prize, strategy, context, 1);
+
+  fputs("\nChosen node is in: ", stdout);
+  printMostFeasible(g, state);
+
+  freeSearchState(state);
+  return questions;
+}
+
+/**
+ * Asks about vertices in the order `strategy` picks them, until one candidate remains or `strategy`
+ * has no vertex left to ask about. Most feasible vertices are left in `state`.
+ *
+ * @param g Pointer to graph object to be searched.
+ * @param state Fresh or reset candidate state of the search.
+ * @param prize Name of the `prize` node.
+ * @param strategy Function that picks the next vertex to ask about.
+ * @param context Pointer to context data of `strategy`.
+ * @param verbose True to print candidates and answers of every question.
+ *
+ * @return Number of questions asked.
+ */
+size_t resolvePrize(Graph *g, SearchState *state, int prize, QueryStrategy strategy, void *context, int verbose) {
+  size_t questions = 0;
+  size_t i;
+  while (state->candidates > 1 && (i = strategy(g, state, context)) < g->vertices) {
+    if (verbose) {
+      fputs("\nProbable nodes: ", stdout);
+      printNodes(g, state);
+      fputc('\n', stdout);
+      if (state->distance) {
+        fprintf(stdout, "Checking distance %llu for node %d: ", state->distance->forward->radius, vertexName(g, i));
+      } else {
+        fprintf(stdout, "Checking adj for node %d: ", vertexName(g, i));
+      }
+    }
+    int adjacent = state->distance ? checkDistance(i, state, prize) : checkAdjacency(g, i, state, prize);
+    if (verbose) {
+      if (state->distance) {
+        adjacent ? fputs("Within", stdout) : fputs("Not within", stdout);
+      } else {
+        adjacent ? fputs("Adjacent", stdout) : fputs("Not adjacent", stdout);
+      }
+      fputc('\n', stdout);
+    }
+    ++questions;
+  }
+
+  return questions;
+}
+
+/**
+ * Resolves many prizes against one read-only graph. Lookups are spread over OpenMP threads and every
+ * thread reuses its own search state and strategy context, nothing is printed while resolving.
+ * Prizes and chosen nodes are input names.
+ *
+ * @param g Pointer to graph object to be searched.
+ * @param reverse Reverse of `g` to use the greedy strategy, NULL to use the sequential strategy.
+ * @param results Array with the `prize` of every lookup set, filled with the outcomes.
+ * @param count Number of lookups in `results`.
+ */
+void resolveBatch(Graph *g, Graph *reverse, BatchResult *results, size_t count) {
+  OMP(parallel)
+  {
+    SearchState *state = createSearchState(g->vertices);
+    GreedyContext *greedy = reverse ? createGreedyContext(g, reverse) : NULL;
+    size_t cursor;
+
+    long long k;
+    OMP(for schedule(dynamic, 4))
+    for (k = 0; k < (long long)count; ++k) {
+      BatchResult *result = &results[k];
+      int prize = vertexId(g, result->prize);
+      resetSearchState(state);
+
+      if (greedy) {
+        resetGreedyContext(greedy);
+        result->questions = resolvePrize(g, state, prize, greedyStrategy, greedy, 0);
+      } else {
+        cursor = 0;
+        result->questions = resolvePrize(g, state, prize, sequentialStrategy, &cursor, 0);
+      }
+
+      result->count = state->candidates;
+      result->chosen = malloc((state->candidates ? state->candidates : 1) * sizeof(*result->chosen));
+      size_t found = 0;
+      size_t w = 0;
+      for (; w < state->alive->words; ++w) {
+        uint64_t word = state->alive->data[w];
+        if (state->adjacentAnswers) {
+          word &= state->best->data[w];
+        }
+        while (word) {
+          result->chosen[found++] = vertexName(g, w * WORD_BITS + countTrailingZeros(word));
+          word &= word - 1;
+        }
+      }
+    }
+
+    freeGreedyContext(greedy);
+    freeSearchState(state);
+  }
+}
+
+/**
+ * Prints every lookup of a batch as its prize, question count and chosen nodes, in input order.
+ *
+ * @param results Array of resolved lookups.
+ * @param count Number of lookups in `results`.
+ */
+void printBatch(BatchResult *results, size_t count) {
+  size_t k = 0;
+  for (; k < count; ++k) {
+    fprintf(stdout, "%d (%llu questions):", results[k].prize, results[k].questions);
+    size_t j = 0;
+    for (; j < results[k].count; ++j) {
+      fprintf(stdout, " %d", results[k].chosen[j]);
+    }
+    fputc('\n', stdout);
+  }
+}
+
+/**
+ * Reads whitespace separated prize vertices from a file.
+ *
+ * @param file_name Name of the file to be read.
+ * @param vertices Vertex count of the graph, every prize must be below it.
+ * @param[out] count Number of prizes read.
+ *
+ * @return Newly allocated array of prizes.
+ */
+int *readPrizes(char *file_name, size_t vertices, size_t *count) {
+  FILE *fp = fopen(file_name, "r");
+  if (!fp) {
+    fprintf(stderr, "Cannot open %s.\n", file_name);
+    exit(EXIT_FAILURE);
+  }
+
+  size_t capacity = 64;
+  int *prizes = malloc(capacity * sizeof(*prizes));
+  *count = 0;
+
+  int prize;
+  while (fscanf(fp, "%d", &prize) == 1) {
+    if (prize < 0 || (size_t)prize >= vertices) {
+      fprintf(stderr, "Prize %d out of range.\n", prize);
+      exit(EXIT_FAILURE);
+    }
+    if (*count == capacity) {
+      capacity *= 2;
+      prizes = realloc(prizes, capacity * sizeof(*prizes));
+    }
+    prizes[(*count)++] = prize;
+  }
+
+  fclose(fp);
+  return prizes;
+}
+
+/**
+ * Returns wall clock time in seconds, for timing batches.
+ *
+ * @return Seconds since an arbitrary starting point.
+ */
+double wallTime() {
+#ifdef _OPENMP
+  return omp_get_wtime();
+#else
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+/**
+ * Frees the graph and its adjacency arrays.
+ * 
+ * @param g Pointer to graph object to be freed.
+ */
+void freeGraph(Graph *g) {
+  if (!g) {
+    return;
+  }
+
+  if (g->limits) {
+    free(g->ends);
+    free(g->limits);
+  }
+  if (g->mapping) {
+    if (!inMapping(g, g->neighbors)) {
+      free(g->neighbors);
+    }
+    unmapFile(g->mapping, g->mappingSize);
+  } else {
+    free(g->offsets);
+    free(g->neighbors);
+    free(g->names);
+    free(g->ids);
+  }
+  free(g);
+}
+
+/**
+ * Handles a completed number. The first number of the file is the vertex count, the first number
+ * of every line after it is the source vertex and the rest are its neighbors.
+ *
+ * @param sc Pointer to scanner state.
+ */
+void scanNumber(InputScanner *sc) {
+  sc->inNumber = 0;
+
+  if (!sc->headerRead) {
+    sc->vertices = (size_t)sc->value;
+    sc->builder = createGraphBuilder(sc->vertices);
+    sc->headerRead = 1;
+    return;
+  }
+  if (sc->lines >= sc->vertices) {
+    return;
+  }
+  if (sc->value >= (long long)sc->vertices) {
+    fprintf(stderr, "Vertex %lld out of range on line %llu.\n", sc->value, sc->lines + 2);
+    exit(EXIT_FAILURE);
+  }
+
+  if (sc->source < 0) {
+    sc->source = sc->value;
+  } else {
+    collectEdge(sc->builder, (int)sc->source, (int)sc->value);
+  }
+}
+
+/**
+ * Handles a line break. The header line is not counted as an adjacency line.
+ *
+ * @param sc Pointer to scanner state.
+ */
+void scanLineEnd(InputScanner *sc) {
+  if (sc->inNumber) {
+    scanNumber(sc);
+  }
+  if (sc->headerRead == 2) {
+    ++sc->lines;
+  } else if (sc->headerRead == 1) {
+    sc->headerRead = 2;
+  }
+  sc->source = -1;
+}
+
+/**
+ * Scans a block of input with a hand written integer scanner, adding edges as soon as they are read.
+ *
+ * @param sc Pointer to scanner state.
+ * @param block Characters to be scanned.
+ * @param length Number of characters in `block`.
+ */
+void scanBlock(InputScanner *sc, const char *block, size_t length) {
+  size_t i = 0;
+  for (; i < length; ++i) {
+    char c = block[i];
+    if (c >= '0' && c <= '9') {
+      if (!sc->inNumber) {
+        sc->inNumber = 1;
+        sc->value = 0;
+      }
+      /* Values past INT_MAX are out of range anyway, stop growing to avoid overflow. */
+      if (sc->value <= INT_MAX) {
+        sc->value = sc->value * 10 + (c - '0');
+      }
+    } else if (c == '\n') {
+      scanLineEnd(sc);
+    } else if (sc->inNumber) {
+      scanNumber(sc);
+    }
+  }
+}
+
+/**
+ * Creates a graph structure with edge relations read from a file input.
+ * The file is read in `READ_BLOCK_SIZE` blocks and no per-line buffer is allocated,
+ * so adjacency lines of any length are read completely.
+ * 
+ * @param file_name Name of the file to be read.
+ * 
+ * @return Pointer to newly created Graph object.
+ */
+Graph *readInput(char *file_name) {
+  FILE *fp = fopen(file_name, "rb");
+  if (!fp) {
+    fprintf(stderr, "Cannot open %s.\n", file_name);
+    exit(EXIT_FAILURE);
+  }
+
+  InputScanner sc = {NULL, 0, 0, 0, 0, 0, -1};
+  char *block = malloc(READ_BLOCK_SIZE);
+
+  size_t length;
+  while ((length = fread(block, 1, READ_BLOCK_SIZE, fp)) > 0) {
+    scanBlock(&sc, block, length);
+  }
+  scanLineEnd(&sc);
+
+  free(block);
+  fclose(fp);
+
+  if (!sc.builder) {
+    fprintf(stderr, "Missing vertex count in %s.\n", file_name);
+    exit(EXIT_FAILURE);
+  }
+  return buildGraph(sc.builder);
+}
+
+/**
+ * Writes a graph as a binary graph file that `mapGraph` can use without parsing. Lists are written
+ * packed even if the graph was updated, names are kept if the graph was renumbered. The file uses
+ * the byte order of this machine.
+ *
+ * @param g Pointer to graph object to be written.
+ * @param file_name Name of the file to be created.
+ */
+void writeGraph(Graph *g, char *file_name) {
+  FILE *fp = fopen(file_name, "wb");
+  if (!fp) {
+    fprintf(stderr, "Cannot create %s.\n", file_name);
+    exit(EXIT_FAILURE);
+  }
+
+  GraphFileHeader header;
+  memcpy(header.magic, GRAPH_MAGIC, sizeof(header.magic));
+  header.byteOrder = GRAPH_BYTE_ORDER;
+  header.flags = g->names ? GRAPH_HAS_NAMES : 0;
+  header.vertices = g->vertices;
+  header.edges = g->edges;
+  int failed = fwrite(&header, sizeof(header), 1, fp) != 1;
+
+  uint64_t offset = 0;
+  size_t i = 0;
+  for (; i <= g->vertices && !failed; ++i) {
+    failed = fwrite(&offset, sizeof(offset), 1, fp) != 1;
+    if (i < g->vertices) {
+      offset += g->ends[i] - g->offsets[i];
+    }
+  }
+  for (i = 0; i < g->vertices && !failed; ++i) {
+    size_t degree = g->ends[i] - g->offsets[i];
+    failed = fwrite(g->neighbors + g->offsets[i], sizeof(*g->neighbors), degree, fp) != degree;
+  }
+  if (g->names && !failed) {
+    failed = fwrite(g->names, sizeof(*g->names), g->vertices, fp) != g->vertices ||
+             fwrite(g->ids, sizeof(*g->ids), g->vertices, fp) != g->vertices;
+  }
+
+  if (fclose(fp) != 0 || failed) {
+    fprintf(stderr, "Cannot write %s.\n", file_name);
+    exit(EXIT_FAILURE);
+  }
+}
+
+/**
+ * Maps a binary graph file into memory and uses it as a graph directly, nothing is read or copied
+ * up front and pages are loaded as the search touches them. The mapping is private, so updating the
+ * graph never changes the file. Only the header and sizes are checked, the file is trusted to come
+ * from `writeGraph`.
+ *
+ * @param file_name Name of the binary graph file.
+ *
+ * @return Pointer to graph object inside the mapping.
+ */
+Graph *mapGraph(char *file_name) {
+  char *base = NULL;
+  size_t size = 0;
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(file_name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, NULL);
+  LARGE_INTEGER length;
+  if (file != INVALID_HANDLE_VALUE && GetFileSizeEx(file, &length)) {
+    size = (size_t)length.QuadPart;
+    HANDLE view = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    if (view) {
+      base = MapViewOfFile(view, FILE_MAP_COPY, 0, 0, 0);
+      CloseHandle(view);
+    }
+  }
+  if (file != INVALID_HANDLE_VALUE) {
+    CloseHandle(file);
+  }
+#else
+  int fd = open(file_name, O_RDONLY);
+  struct stat info;
+  if (fd >= 0 && fstat(fd, &info) == 0 && info.st_size > 0) {
+    size = (size_t)info.st_size;
+    base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED) {
+      base = NULL;
+    }
+  }
+  if (fd >= 0) {
+    close(fd);
+  }
+#endif
+
+  if (!base) {
+    fprintf(stderr, "Cannot map %s.\n", file_name);
+    exit(EXIT_FAILURE);
+  }
+
+  GraphFileHeader *header = (GraphFileHeader *)base;
+  if (size < sizeof(*header) || memcmp(header->magic, GRAPH_MAGIC, sizeof(header->magic)) != 0 ||
+      header->byteOrder != GRAPH_BYTE_ORDER || sizeof(size_t) != sizeof(uint64_t)) {
+    fprintf(stderr, "%s is not a binary graph file of this machine.\n", file_name);
+    exit(EXIT_FAILURE);
+  }
+
+  size_t vertices = (size_t)header->vertices;
+  size_t edges = (size_t)header->edges;
+  size_t names = (header->flags & GRAPH_HAS_NAMES) ? 2 * vertices : 0;
+  size_t expected = sizeof(*header) + (vertices + 1) * sizeof(uint64_t) + (edges + names) * sizeof(int);
+  if (size < expected) {
+    fprintf(stderr, "%s is truncated.\n", file_name);
+    exit(EXIT_FAILURE);
+  }
+
+  Graph *graph = malloc(sizeof(*graph));
+  graph->vertices = vertices;
+  graph->edges = edges;
+  graph->offsets = (size_t *)(base + sizeof(*header));
+  graph->ends = graph->offsets + 1;
+  graph->limits = NULL;
+  graph->neighbors = (int *)(graph->offsets + vertices + 1);
+  graph->capacity = edges;
+  graph->used = edges;
+  graph->garbage = 0;
+  graph->names = names ? graph->neighbors + edges : NULL;
+  graph->ids = names ? graph->names + vertices : NULL;
+  graph->mapping = base;
+  graph->mappingSize = size;
+
+  return graph;
+}
+
+/**
+ * Releases a file mapping made by `mapGraph`.
+ *
+ * @param base Start of the mapping.
+ * @param size Size of the mapping in bytes.
+ */
+void unmapFile(void *base, size_t size) {
+#ifdef _WIN32
+  (void)size;
+  UnmapViewOfFile(base);
+#else
+  munmap(base, size);
+#endif
+}
+
+/**
+ * Checks if a pointer points inside the file mapping of a graph.
+ *
+ * @param g Pointer to graph object.
+ * @param p Pointer to be checked.
+ *
+ * @return True if `p` is inside the mapping, false if not or if the graph is not mapped.
+ */
+int inMapping(Graph *g, const void *p) {
+  const char *base = g->mapping;
+  return base && (const char *)p >= base && (const char *)p < base + g->mappingSize;
+}
+
+/**
+ * Orders integers ascending, for `qsort`.
+ *
+ * @param a, b Pointers to the integers to be compared.
+ *
+ * @return Negative, zero or positive as `a` comes before, with or after `b`.
+ */
+int compareInts(const void *a, const void *b) {
+  int x = *(const int *)a;
+  int y = *(const int *)b;
+  return (x > y) - (x < y);
 }
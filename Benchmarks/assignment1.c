@@ -0,0 +1,64 @@
+#include "bench.h"
+#include "../Assignments/1/23011610.c"
+
+/*
+ * Assignment 1: matching nuts and bolts with the paired quicksort. Keys come in the order of the
+ * input shape, locks are an independent random permutation of the same values.
+ */
+
+typedef struct {
+  int *keys;
+  int *locks;
+  int *workKeys;
+  int *workLocks;
+  size_t n;
+  unsigned seed;
+} SortCase;
+
+static void prepareSort(void *context) {
+  SortCase *c = context;
+  memcpy(c->workKeys, c->keys, c->n * sizeof(int));
+  memcpy(c->workLocks, c->locks, c->n * sizeof(int));
+  srand(c->seed);
+}
+
+static void runSort(void *context) {
+  SortCase *c = context;
+  quicksort(c->workKeys, c->workLocks, 0, (int)c->n - 1);
+}
+
+int main(int argc, char *argv[]) {
+  static const size_t sizes[] = {1000, 10000, 100000};
+  static const int shapes[] = {SHAPE_RANDOM, SHAPE_SORTED, SHAPE_REVERSED, SHAPE_ORGAN_PIPE};
+  Bench bench;
+  benchInit(&bench, "assignment1", argc, argv);
+  benchSizes(&bench, sizes, sizeof(sizes) / sizeof(*sizes));
+
+  size_t s = 0;
+  for (; s < bench.sizeCount; ++s) {
+    size_t n = bench.sizes[s];
+    SortCase c;
+    c.n = n;
+    c.seed = (unsigned)bench.seed;
+    c.keys = malloc(n * sizeof(int));
+    c.locks = malloc(n * sizeof(int));
+    c.workKeys = malloc(n * sizeof(int));
+    c.workLocks = malloc(n * sizeof(int));
+
+    size_t k = 0;
+    for (; k < sizeof(shapes) / sizeof(*shapes); ++k) {
+      uint64_t rng = benchStream(&bench, s * 16 + k);
+      benchKeys(c.keys, n, shapes[k], &rng);
+      benchKeys(c.locks, n, SHAPE_RANDOM, &rng);
+      benchRun(&bench, "quicksort", shapeName(shapes[k]), n, prepareSort, runSort, &c);
+    }
+
+    free(c.keys);
+    free(c.locks);
+    free(c.workKeys);
+    free(c.workLocks);
+  }
+
+  benchFinish(&bench);
+  return 0;
+}
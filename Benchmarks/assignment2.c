@@ -0,0 +1,122 @@
+#include "bench.h"
+#include "../Assignments/2/23011610.c"
+
+/*
+ * Assignment 2: users walking their circular playlists. The program's own generators build the
+ * songs and playlists from `rand`, seeded per case. "long-jumps" replaces every move of the
+ * listening lists with a jump of half a playlist, the longest walk there is.
+ */
+
+/* Users of every case. */
+#define BENCH_USERS 32
+
+typedef struct {
+  playlist **users;
+  size_t K;
+  int **playtimes;    /* Result of the last `playSongs` run. */
+  int **saved;        /* Play times `displayTop10` starts from, it marks them as it goes. */
+  int **work;
+} PlayCase;
+
+static void freePlaytimes(int **playtimes, size_t K) {
+  size_t i = 0;
+  for (; playtimes && i < K; ++i) {
+    free(playtimes[i]);
+  }
+  free(playtimes);
+}
+
+static void preparePlay(void *context) {
+  PlayCase *c = context;
+  freePlaytimes(c->playtimes, c->K);
+  c->playtimes = NULL;
+}
+
+static void runPlay(void *context) {
+  PlayCase *c = context;
+  c->playtimes = playSongs(c->users, c->K);
+}
+
+static void prepareTop10(void *context) {
+  PlayCase *c = context;
+  size_t i = 0;
+  for (; i < c->K; ++i) {
+    memcpy(c->work[i], c->saved[i], c->users[i]->size * sizeof(int));
+  }
+}
+
+static void runTop10(void *context) {
+  PlayCase *c = context;
+  displayTop10(c->users, c->work, c->K);
+}
+
+static void freeUsers(playlist **users, size_t K) {
+  size_t i = 0;
+  for (; i < K; ++i) {
+    listNode *node = users[i]->songs->head;
+    size_t j = 0;
+    for (; j < users[i]->size; ++j) {
+      listNode *next = node->next;
+      free(node);
+      node = next;
+    }
+    free(users[i]->songs);
+    free(users[i]->listeningList);
+    free(users[i]);
+  }
+  free(users);
+}
+
+int main(int argc, char *argv[]) {
+  static const size_t sizes[] = {1000, 5000, 20000};
+  static const char *inputs[] = {"random", "long-jumps"};
+  Bench bench;
+  benchInit(&bench, "assignment2", argc, argv);
+  benchSizes(&bench, sizes, sizeof(sizes) / sizeof(*sizes));
+
+  size_t s = 0;
+  for (; s < bench.sizeCount; ++s) {
+    size_t N = bench.sizes[s];
+    size_t k = 0;
+    for (; k < sizeof(inputs) / sizeof(*inputs); ++k) {
+      srand((unsigned)benchStream(&bench, s * 16 + k));
+      song **songs = createSongs(N);
+      PlayCase c;
+      c.K = BENCH_USERS;
+      c.users = createUsers(c.K, N, songs);
+      c.playtimes = NULL;
+      size_t i;
+      if (k == 1) {
+        for (i = 0; i < c.K; ++i) {
+          size_t j = 1;
+          for (; j < c.users[i]->listeningListCount; ++j) {
+            c.users[i]->listeningList[j] = (int)(c.users[i]->size / 2);
+          }
+        }
+      }
+
+      benchRun(&bench, "playSongs", inputs[k], N, preparePlay, runPlay, &c);
+
+      if (benchWants(&bench, "displayTop10")) {
+        c.saved = playSongs(c.users, c.K);
+        c.work = malloc(c.K * sizeof(*c.work));
+        for (i = 0; i < c.K; ++i) {
+          c.work[i] = malloc(c.users[i]->size * sizeof(int));
+        }
+        benchRun(&bench, "displayTop10", inputs[k], N, prepareTop10, runTop10, &c);
+        freePlaytimes(c.saved, c.K);
+        freePlaytimes(c.work, c.K);
+      }
+
+      freePlaytimes(c.playtimes, c.K);
+      freeUsers(c.users, c.K);
+      for (i = 0; i < N; ++i) {
+        free(songs[i]);
+      }
+      free(songs);
+    }
+  }
+
+  benchFinish(&bench);
+  return 0;
+}
@@ -0,0 +1,102 @@
+#include "bench.h"
+#include "../Assignments/3/23011610.c"
+
+/*
+ * Assignment 3: aggregates over the employee tree. "random" attaches every employee to a random
+ * earlier one, "wide" puts everybody under the root and "deep" makes one long chain, which the
+ * recursive `getHeight` and `freeTree` follow to its end.
+ */
+
+#define TREE_RANDOM 0
+#define TREE_WIDE 1
+#define TREE_DEEP 2
+
+/**
+ * Builds an employee tree. Children are linked through a last child array instead of `addChild`,
+ * which walks the siblings and would make wide trees quadratic to build.
+ */
+static Node *buildTree(size_t n, int shape, uint64_t *rng) {
+  Node **nodes = malloc(n * sizeof(*nodes));
+  Node **lastChild = calloc(n, sizeof(*lastChild));
+  size_t i = 0;
+  for (; i < n; ++i) {
+    char name[21];
+    sprintf(name, "E%llu", (unsigned long long)i);
+    nodes[i] = createNode(createEmployee(name, 20 + benchBelow(rng, 45), 1000 + benchBelow(rng, 9000)));
+    if (!i) {
+      continue;
+    }
+
+    size_t parent = shape == TREE_WIDE ? 0 : shape == TREE_DEEP ? i - 1 : benchBelow(rng, i);
+    if (lastChild[parent]) {
+      lastChild[parent]->sibling = nodes[i];
+    } else {
+      nodes[parent]->child = nodes[i];
+    }
+    lastChild[parent] = nodes[i];
+  }
+
+  Node *root = nodes[0];
+  free(nodes);
+  free(lastChild);
+  return root;
+}
+
+typedef struct {
+  Node *root;
+  size_t height;
+  double sink;
+} TreeCase;
+
+static void runHeight(void *context) {
+  TreeCase *c = context;
+  c->sink += getHeight(c->root);
+}
+
+static void runCountLevels(void *context) {
+  TreeCase *c = context;
+  countLevels(c->root, c->height);
+}
+
+static void runAgeAvg(void *context) {
+  TreeCase *c = context;
+  c->sink += computeAgeAvg(c->root);
+}
+
+static void runTotalPayment(void *context) {
+  TreeCase *c = context;
+  c->sink += computeTotalPayment(c->root);
+}
+
+int main(int argc, char *argv[]) {
+  static const size_t sizes[] = {1000, 10000, 50000};
+  static const char *inputs[] = {"random", "wide", "deep"};
+  Bench bench;
+  benchInit(&bench, "assignment3", argc, argv);
+  benchSizes(&bench, sizes, sizeof(sizes) / sizeof(*sizes));
+
+  size_t s = 0;
+  for (; s < bench.sizeCount; ++s) {
+    size_t n = bench.sizes[s];
+    int shape = 0;
+    for (; shape < 3; ++shape) {
+      uint64_t rng = benchStream(&bench, s * 16 + shape);
+      TreeCase c;
+      c.root = buildTree(n, shape, &rng);
+      c.height = getHeight(c.root);
+      c.sink = 0;
+
+      benchRun(&bench, "getHeight", inputs[shape], n, NULL, runHeight, &c);
+      benchRun(&bench, "countLevels", inputs[shape], n, NULL, runCountLevels, &c);
+      benchRun(&bench, "computeAgeAvg", inputs[shape], n, NULL, runAgeAvg, &c);
+      benchRun(&bench, "computeTotalPayment", inputs[shape], n, NULL, runTotalPayment, &c);
+
+      /* Keeps the results alive, stdout goes to the null device. */
+      printf("%f\n", c.sink);
+      freeTree(c.root);
+    }
+  }
+
+  benchFinish(&bench);
+  return 0;
+}
@@ -0,0 +1,210 @@
+#include "bench.h"
+#include "../Assignments/4/23011610.c"
+
+/*
+ * Assignment 4: reading the adjacency input and finding prize nodes. Every vertex gets
+ * GRAPH_DEGREE out-neighbors: uniform in "random", drawn towards low numbers in "hubs" so a few
+ * vertices are in most lists, and the next vertices around a ring in "ring". The searches resolve
+ * PRIZE_COUNT random prizes per run, silently as batch mode does. The update cases add and then
+ * remove UPDATE_COUNT random edges, alone in "updateEdges" and one after every question of a
+ * sequential search with kept answers in "searchWithUpdates", so every run leaves the edges as it
+ * found them.
+ */
+
+#define GRAPH_DEGREE 8
+#define PRIZE_COUNT 16
+#define UPDATE_COUNT 4096
+
+#define GRAPH_RANDOM 0
+#define GRAPH_HUBS 1
+#define GRAPH_RING 2
+
+/**
+ * Writes a graph in the input format: the vertex count, then one line per vertex with the vertex
+ * followed by its neighbors.
+ */
+static char *graphText(size_t n, int shape, uint64_t *rng, size_t *length) {
+  size_t capacity = (n + 1) * (GRAPH_DEGREE + 1) * 12 + 32;
+  char *text = malloc(capacity);
+  size_t at = (size_t)sprintf(text, "%llu\n", (unsigned long long)n);
+  size_t v = 0;
+  for (; v < n; ++v) {
+    at += (size_t)sprintf(text + at, "%llu", (unsigned long long)v);
+    int d = 0;
+    for (; d < GRAPH_DEGREE; ++d) {
+      size_t u;
+      if (shape == GRAPH_HUBS) {
+        double x = (double)benchRandom(rng) / 18446744073709551616.0;
+        u = (size_t)(x * x * x * n);
+      } else if (shape == GRAPH_RING) {
+        u = (v + 1 + d) % n;
+      } else {
+        u = benchBelow(rng, n);
+      }
+      at += (size_t)sprintf(text + at, " %llu", (unsigned long long)u);
+    }
+    text[at++] = '\n';
+  }
+  *length = at;
+  return text;
+}
+
+typedef struct {
+  char *text;
+  size_t length;
+  Graph *g;
+  Graph *reverse;
+  Graph *parsed;
+  int prizes[PRIZE_COUNT];
+  SearchState *state;
+  GreedyContext *greedy;
+  size_t questions;
+  int updates[UPDATE_COUNT][2];
+  char added[UPDATE_COUNT];
+} GraphCase;
+
+static void prepareParse(void *context) {
+  GraphCase *c = context;
+  freeGraph(c->parsed);
+  c->parsed = NULL;
+}
+
+static void runParse(void *context) {
+  GraphCase *c = context;
+  InputScanner sc = {NULL, 0, 0, 0, 0, 0, -1};
+  scanBlock(&sc, c->text, c->length);
+  scanLineEnd(&sc);
+  c->parsed = buildGraph(sc.builder);
+}
+
+static void runSequential(void *context) {
+  GraphCase *c = context;
+  int k = 0;
+  for (; k < PRIZE_COUNT; ++k) {
+    size_t cursor = 0;
+    resetSearchState(c->state);
+    c->questions += resolvePrize(c->g, c->state, c->prizes[k], sequentialStrategy, &cursor, 0);
+  }
+}
+
+static void runGreedy(void *context) {
+  GraphCase *c = context;
+  int k = 0;
+  for (; k < PRIZE_COUNT; ++k) {
+    resetSearchState(c->state);
+    resetGreedyContext(c->greedy);
+    c->questions += resolvePrize(c->g, c->state, c->prizes[k], greedyStrategy, c->greedy, 0);
+  }
+}
+
+static void runUpdates(void *context) {
+  GraphCase *c = context;
+  int k = 0;
+  for (; k < UPDATE_COUNT; ++k) {
+    c->added[k] = (char)addEdge(c->g, c->updates[k][0], c->updates[k][1]);
+  }
+  for (k = 0; k < UPDATE_COUNT; ++k) {
+    if (c->added[k]) {
+      removeEdge(c->g, c->updates[k][0], c->updates[k][1]);
+    }
+  }
+}
+
+/**
+ * Resolves the prizes like `resolvePrize` does, adding the next edge of `updates` after every
+ * question and correcting the candidates in flight. The added edges are removed after each prize.
+ */
+static void runSearchWithUpdates(void *context) {
+  GraphCase *c = context;
+  int k = 0;
+  for (; k < PRIZE_COUNT; ++k) {
+    size_t cursor = 0;
+    size_t next = 0;
+    size_t i;
+    resetSearchState(c->state);
+    while (c->state->candidates > 1 && (i = sequentialStrategy(c->g, c->state, &cursor)) < c->g->vertices) {
+      checkAdjacency(c->g, i, c->state, c->prizes[k]);
+      ++c->questions;
+      if (next < UPDATE_COUNT) {
+        int u = c->updates[next][0], v = c->updates[next][1];
+        c->added[next] = (char)addEdge(c->g, u, v);
+        if (c->added[next]) {
+          updateCandidates(c->state, u, v, 1);
+        }
+        ++next;
+      }
+    }
+    while (next > 0) {
+      --next;
+      if (c->added[next]) {
+        removeEdge(c->g, c->updates[next][0], c->updates[next][1]);
+      }
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  static const size_t sizes[] = {1000, 10000, 100000};
+  static const char *inputs[] = {"random", "hubs", "ring"};
+  Bench bench;
+  benchInit(&bench, "assignment4", argc, argv);
+  benchSizes(&bench, sizes, sizeof(sizes) / sizeof(*sizes));
+
+  size_t s = 0;
+  for (; s < bench.sizeCount; ++s) {
+    size_t n = bench.sizes[s];
+    int shape = 0;
+    for (; shape < 3; ++shape) {
+      uint64_t rng = benchStream(&bench, s * 16 + shape);
+      GraphCase c;
+      c.text = graphText(n, shape, &rng, &c.length);
+      c.parsed = NULL;
+      c.questions = 0;
+
+      benchRun(&bench, "parseGraph", inputs[shape], n, prepareParse, runParse, &c);
+
+      int updates = benchWants(&bench, "updateEdges") || benchWants(&bench, "searchWithUpdates");
+      if (updates || benchWants(&bench, "searchSequential") || benchWants(&bench, "searchGreedy")) {
+        prepareParse(&c);
+        runParse(&c);
+        c.g = c.parsed;
+        c.parsed = NULL;
+        int k = 0;
+        for (; k < PRIZE_COUNT; ++k) {
+          c.prizes[k] = (int)benchBelow(&rng, n);
+        }
+        c.state = createSearchState(n);
+        benchRun(&bench, "searchSequential", inputs[shape], n, NULL, runSequential, &c);
+
+        if (benchWants(&bench, "searchGreedy")) {
+          c.reverse = transposeGraph(c.g);
+          c.greedy = createGreedyContext(c.g, c.reverse);
+          benchRun(&bench, "searchGreedy", inputs[shape], n, NULL, runGreedy, &c);
+          freeGreedyContext(c.greedy);
+          freeGraph(c.reverse);
+        }
+
+        /* Last, as the first update moves the graph to the updatable layout for good. */
+        if (updates) {
+          for (k = 0; k < UPDATE_COUNT; ++k) {
+            c.updates[k][0] = (int)benchBelow(&rng, n);
+            c.updates[k][1] = (int)benchBelow(&rng, n);
+          }
+          benchRun(&bench, "updateEdges", inputs[shape], n, NULL, runUpdates, &c);
+          trackAnswers(c.state);
+          benchRun(&bench, "searchWithUpdates", inputs[shape], n, NULL, runSearchWithUpdates, &c);
+        }
+        freeSearchState(c.state);
+        freeGraph(c.g);
+      }
+
+      /* Keeps the results alive, stdout goes to the null device. */
+      printf("%llu\n", (unsigned long long)c.questions);
+      freeGraph(c.parsed);
+      free(c.text);
+    }
+  }
+
+  benchFinish(&bench);
+  return 0;
+}
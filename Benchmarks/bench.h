@@ -0,0 +1,421 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+/*
+ * Shared part of the benchmark drivers: command line options, timed runs with warmup, input
+ * generators and JSON or CSV records. A driver includes this header first, then the source of one
+ * program compiled with -DBENCHMARK, which leaves the program's `main` out so its routines can be
+ * called directly.
+ */
+
+/* The feature macros of the programs must come before the first system header, which this file
+ * includes ahead of them: `fileno` and `isatty` for Lab 1, 64-bit `fseeko` offsets for Lab 3. */
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#define _FILE_OFFSET_BITS 64
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <io.h>
+#define dup _dup
+#define fdopen _fdopen
+#define fileno _fileno
+#define NULL_DEVICE "NUL"
+#else
+#include <unistd.h>
+#define NULL_DEVICE "/dev/null"
+#endif
+
+/* Untimed and timed runs of every case unless given on the command line. */
+#define BENCH_WARMUP 2
+#define BENCH_REPEATS 10
+/* Most `--size` options a run takes. */
+#define BENCH_MAX_SIZES 16
+
+#define FORMAT_JSON 0
+#define FORMAT_CSV 1
+
+/* Orders of the keys `benchKeys` generates. */
+#define SHAPE_RANDOM 0
+#define SHAPE_SORTED 1
+#define SHAPE_REVERSED 2
+#define SHAPE_ORGAN_PIPE 3        /* Ascending first half, descending second half. */
+#define SHAPE_NEARLY_SORTED 4     /* Sorted with one key in a hundred swapped away. */
+
+typedef struct {
+  const char *program;
+  const char *label;      /* Copied into every record to tell versions apart, a commit hash for one. */
+  const char *filter;     /* Only routines whose name contains it are run, NULL for all. */
+  int format;
+  int warmup;
+  int repeats;
+  size_t sizes[BENCH_MAX_SIZES];
+  size_t sizeCount;       /* 0 until sizes are given on the command line or by `benchSizes`. */
+  uint64_t seed;
+  FILE *out;              /* Records go here, whatever the programs print goes to the null device. */
+  int headerDone;
+  double items;           /* Operations one run of the next case performs, so rates can be derived, 0 if not counted. */
+  double flops;           /* Arithmetic operations of one run, for GFLOP/s, 0 if not counted. */
+  double bytes;           /* Bytes one run reads and writes at least once, for GB/s, 0 if not counted. */
+} Bench;
+
+/* One step of a case, `prepare` runs untimed before every `run`. */
+typedef void (*BenchStep)(void *context);
+
+/**
+ * Prints the options of a driver.
+ *
+ * @param program Name of the driver.
+ */
+static inline void benchUsage(const char *program) {
+  fprintf(stderr,
+          "Usage: %s [--format json|csv] [--size N]... [--warmup N] [--repeats N]\n"
+          "          [--seed N] [--label TEXT] [--filter ROUTINE]\n", program);
+}
+
+/**
+ * Reads the command line and moves the program's own output out of the way: records are written
+ * to a copy of stdout, stdout itself is sent to the null device.
+ *
+ * @param bench Pointer to options to be filled.
+ * @param program Name of the program in the records.
+ * @param argc, argv Command line of the driver.
+ */
+static inline void benchInit(Bench *bench, const char *program, int argc, char *argv[]) {
+  bench->program = program;
+  bench->label = "";
+  bench->filter = NULL;
+  bench->format = FORMAT_JSON;
+  bench->warmup = BENCH_WARMUP;
+  bench->repeats = BENCH_REPEATS;
+  bench->sizeCount = 0;
+  bench->seed = 1;
+  bench->headerDone = 0;
+  bench->items = 0;
+  bench->flops = 0;
+  bench->bytes = 0;
+
+  int i = 1;
+  for (; i < argc; ++i) {
+    if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+      ++i;
+      if (strcmp(argv[i], "json") == 0) {
+        bench->format = FORMAT_JSON;
+      } else if (strcmp(argv[i], "csv") == 0) {
+        bench->format = FORMAT_CSV;
+      } else {
+        fprintf(stderr, "Unknown format %s.\n", argv[i]);
+        exit(EXIT_FAILURE);
+      }
+    } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      long long value = atoll(argv[++i]);
+      if (value < 1 || bench->sizeCount == BENCH_MAX_SIZES) {
+        fprintf(stderr, "Sizes must be positive, at most %d of them.\n", BENCH_MAX_SIZES);
+        exit(EXIT_FAILURE);
+      }
+      bench->sizes[bench->sizeCount++] = (size_t)value;
+    } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+      bench->warmup = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--repeats") == 0 && i + 1 < argc) {
+      bench->repeats = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      bench->seed = strtoull(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--label") == 0 && i + 1 < argc) {
+      bench->label = argv[++i];
+    } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+      bench->filter = argv[++i];
+    } else {
+      benchUsage(argv[0]);
+      exit(EXIT_FAILURE);
+    }
+  }
+  if (bench->warmup < 0 || bench->repeats < 1) {
+    fputs("Warmup must not be negative and repeats must be positive.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+
+  fflush(stdout);
+  bench->out = fdopen(dup(fileno(stdout)), "w");
+  if (!bench->out || !freopen(NULL_DEVICE, "w", stdout)) {
+    fputs("Cannot redirect output.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+}
+
+/**
+ * Flushes the records.
+ *
+ * @param bench Pointer to options.
+ */
+static inline void benchFinish(Bench *bench) {
+  fclose(bench->out);
+}
+
+/**
+ * Falls back to the driver's sizes if none were given on the command line.
+ *
+ * @param bench Pointer to options.
+ * @param sizes Default sizes of the driver.
+ * @param count Number of default sizes, at most BENCH_MAX_SIZES.
+ */
+static inline void benchSizes(Bench *bench, const size_t *sizes, size_t count) {
+  if (!bench->sizeCount) {
+    memcpy(bench->sizes, sizes, count * sizeof(*sizes));
+    bench->sizeCount = count;
+  }
+}
+
+/**
+ * Tells whether a routine passes the filter, so drivers can skip building inputs nobody uses.
+ *
+ * @param bench Pointer to options.
+ * @param routine Name of the routine.
+ *
+ * @return 1 if the routine is to be run.
+ */
+static inline int benchWants(Bench *bench, const char *routine) {
+  return !bench->filter || strstr(routine, bench->filter) != NULL;
+}
+
+/**
+ * Monotonic clock.
+ *
+ * @return Seconds since an arbitrary starting point.
+ */
+static inline double benchNow(void) {
+  struct timespec ts;
+#ifdef _WIN32
+  timespec_get(&ts, TIME_UTC);
+#else
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+  return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Orders run times for the median.
+ */
+static inline int compareTimes(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * Runs a case `warmup` times untimed and `repeats` times timed, then writes one record with the
+ * minimum, median, mean and maximum time of a run. The `items`, `flops` and `bytes` counts the
+ * driver set for the case are written along and cleared afterwards.
+ *
+ * @param bench Pointer to options.
+ * @param routine Name of the routine being timed.
+ * @param input Name of the input shape.
+ * @param size Input size, as the driver counts it.
+ * @param prepare Step to restore the input before every run, NULL if runs leave it unchanged.
+ * @param run Step to be timed.
+ * @param context Data of the steps.
+ */
+static inline void benchRun(Bench *bench, const char *routine, const char *input, size_t size,
+                            BenchStep prepare, BenchStep run, void *context) {
+  if (!benchWants(bench, routine)) {
+    bench->items = 0;
+    bench->flops = 0;
+    bench->bytes = 0;
+    return;
+  }
+
+  double *times = malloc(bench->repeats * sizeof(*times));
+  if (!times) {
+    fputs("Out of memory.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+  int i = 0;
+  for (; i < bench->warmup + bench->repeats; ++i) {
+    if (prepare) {
+      prepare(context);
+    }
+    double start = benchNow();
+    run(context);
+    double elapsed = benchNow() - start;
+    if (i >= bench->warmup) {
+      times[i - bench->warmup] = elapsed * 1e9;
+    }
+  }
+
+  qsort(times, bench->repeats, sizeof(*times), compareTimes);
+  double mean = 0;
+  for (i = 0; i < bench->repeats; ++i) {
+    mean += times[i] / bench->repeats;
+  }
+  double median = bench->repeats % 2 ? times[bench->repeats / 2]
+                                     : (times[bench->repeats / 2 - 1] + times[bench->repeats / 2]) / 2;
+
+  if (bench->format == FORMAT_CSV) {
+    if (!bench->headerDone) {
+      fputs("program,routine,input,size,label,repeats,min_ns,median_ns,mean_ns,max_ns,items,flops,bytes\n",
+            bench->out);
+      bench->headerDone = 1;
+    }
+    fprintf(bench->out, "%s,%s,%s,%llu,%s,%d,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f\n", bench->program, routine,
+            input, (unsigned long long)size, bench->label, bench->repeats, times[0], median, mean,
+            times[bench->repeats - 1], bench->items, bench->flops, bench->bytes);
+  } else {
+    fprintf(bench->out,
+            "{\"program\":\"%s\",\"routine\":\"%s\",\"input\":\"%s\",\"size\":%llu,\"label\":\"%s\","
+            "\"repeats\":%d,\"min_ns\":%.0f,\"median_ns\":%.0f,\"mean_ns\":%.0f,\"max_ns\":%.0f,"
+            "\"items\":%.0f,\"flops\":%.0f,\"bytes\":%.0f}\n",
+            bench->program, routine, input, (unsigned long long)size, bench->label, bench->repeats,
+            times[0], median, mean, times[bench->repeats - 1], bench->items, bench->flops, bench->bytes);
+  }
+  fflush(bench->out);
+  free(times);
+  bench->items = 0;
+  bench->flops = 0;
+  bench->bytes = 0;
+}
+
+/**
+ * Next value of a xorshift64* generator, the same sequence on every platform unlike `rand`.
+ *
+ * @param state Generator state, not 0.
+ *
+ * @return Random 64-bit value.
+ */
+static inline uint64_t benchRandom(uint64_t *state) {
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return *state * 0x2545F4914F6CDD1Dull;
+}
+
+/**
+ * Random value below a bound.
+ *
+ * @param state Generator state.
+ * @param bound Bound, not 0.
+ *
+ * @return Value in `[0, bound)`.
+ */
+static inline size_t benchBelow(uint64_t *state, size_t bound) {
+  return (size_t)(benchRandom(state) % bound);
+}
+
+/**
+ * Starts a generator from the run's seed and a case number, so every case gets the same input
+ * whatever else runs before it.
+ *
+ * @param bench Pointer to options.
+ * @param stream Case number.
+ *
+ * @return Generator state.
+ */
+static inline uint64_t benchStream(Bench *bench, uint64_t stream) {
+  uint64_t state = (bench->seed + 1) * 0x9E3779B97F4A7C15ull ^ (stream + 1) * 0xBF58476D1CE4E5B9ull;
+  return state ? state : 1;
+}
+
+/**
+ * Name of a key shape for the records.
+ *
+ * @param shape SHAPE_ value.
+ *
+ * @return Name of the shape.
+ */
+static inline const char *shapeName(int shape) {
+  switch (shape) {
+    case SHAPE_SORTED:
+      return "sorted";
+    case SHAPE_REVERSED:
+      return "reversed";
+    case SHAPE_ORGAN_PIPE:
+      return "organ-pipe";
+    case SHAPE_NEARLY_SORTED:
+      return "nearly-sorted";
+    default:
+      return "random";
+  }
+}
+
+/**
+ * Shuffles an array with Fisher-Yates.
+ *
+ * @param items Array to be shuffled.
+ * @param n Number of items.
+ * @param state Generator state.
+ */
+static inline void benchShuffle(int *items, size_t n, uint64_t *state) {
+  size_t i = n;
+  while (i > 1) {
+    size_t j = benchBelow(state, i--);
+    int temp = items[i];
+    items[i] = items[j];
+    items[j] = temp;
+  }
+}
+
+/**
+ * Fills an array with the keys `0` to `n - 1`, each once, in the order of a shape.
+ *
+ * @param out Array of `n` keys.
+ * @param n Number of keys.
+ * @param shape SHAPE_ value.
+ * @param state Generator state.
+ */
+static inline void benchKeys(int *out, size_t n, int shape, uint64_t *state) {
+  size_t i = 0;
+  for (; i < n; ++i) {
+    out[i] = (int)i;
+  }
+
+  if (shape == SHAPE_RANDOM) {
+    benchShuffle(out, n, state);
+  } else if (shape == SHAPE_REVERSED) {
+    for (i = 0; i < n; ++i) {
+      out[i] = (int)(n - 1 - i);
+    }
+  } else if (shape == SHAPE_ORGAN_PIPE) {
+    /* Even keys going up, then odd keys coming down. */
+    size_t half = (n + 1) / 2;
+    for (i = 0; i < n; ++i) {
+      out[i] = (int)(i < half ? 2 * i : 2 * (n - 1 - i) + 1);
+    }
+  } else if (shape == SHAPE_NEARLY_SORTED) {
+    for (i = 0; i < n / 100; ++i) {
+      size_t a = benchBelow(state, n), b = benchBelow(state, n);
+      int temp = out[a];
+      out[a] = out[b];
+      out[b] = temp;
+    }
+  }
+}
+
+/**
+ * Fills an array with decimal digits.
+ *
+ * @param out Array of `n` digits.
+ * @param n Number of digits.
+ * @param nines 1 for all nines, the longest carry chains, 0 for random digits.
+ * @param state Generator state.
+ */
+static inline void benchDigits(int *out, size_t n, int nines, uint64_t *state) {
+  size_t i = 0;
+  for (; i < n; ++i) {
+    out[i] = nines ? 9 : (int)benchBelow(state, 10);
+  }
+}
+
+/**
+ * Portable stand-in for the Annex K `fopen_s` that Assignments 1 and 2 open their input with,
+ * only MSVC ships it.
+ */
+#ifndef _MSC_VER
+static inline int fopen_s(FILE **file, const char *name, const char *mode) {
+  *file = fopen(name, mode);
+  return *file ? 0 : 1;
+}
+#endif
+
+#endif
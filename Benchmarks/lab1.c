@@ -0,0 +1,397 @@
+#include "bench.h"
+#include "../Labs/Lab_1.c"
+
+/*
+ * Lab 1: turning a dense n x n matrix into triplets and CSR, then multiplying with a vector.
+ * Nonzeros are spread at random with a density of 1% or 10%, sit on a band of five diagonals, or
+ * fill the whole matrix, the worst case for a sparse form.
+ *
+ * Element lookups take queries of which half are nonzeros and half random positions, mostly zeros.
+ * A run makes LOOKUP_COUNT lookups through CSR, the hash index or `lookupBatch`, but only
+ * SCAN_COUNT through the linear scan of the triplets the lab started with; `items` holds the
+ * count, so lookups per second compare directly.
+ *
+ * The kernels run on CSR matrices generated directly, KERNEL_SCALE times as many rows as the size
+ * and KERNEL_ROW_NONZEROS nonzeros per row on average: every row gets that many in "uniform", row
+ * lengths fall off as 1 / rank in "power-law" (rows shuffled) so a few rows hold most nonzeros.
+ * Records carry the flop count and the least bytes a run moves, so GFLOP/s is `flops / median_ns`
+ * and GB/s is `bytes / median_ns`. Integer kernels count integer operations as flops.
+ */
+
+#define LOOKUP_COUNT 65536
+#define SCAN_COUNT 64
+
+#define KERNEL_SCALE 16
+#define KERNEL_ROW_NONZEROS 16
+/* Columns of the dense matrix `spmm` multiplies with. */
+#define SPMM_WIDTH 8
+
+typedef struct {
+  int *dense;
+  int n;
+  SparseMatrix *triplets;
+  SparseMatrix *converted;
+  CsrMatrix *csr;
+  CsrMatrix *built;
+  double *x;
+  double *y;
+  HashIndex *index;
+  int *rows;
+  int *cols;
+  int *values;
+  size_t found;
+} MatrixCase;
+
+static void prepareFromDense(void *context) {
+  MatrixCase *c = context;
+  if (c->converted) {
+    freeSparseMatrix(c->converted);
+    c->converted = NULL;
+  }
+}
+
+static void runFromDense(void *context) {
+  MatrixCase *c = context;
+  c->converted = fromDense(c->dense, c->n, c->n);
+}
+
+static void prepareToCsr(void *context) {
+  MatrixCase *c = context;
+  if (c->built) {
+    freeCsr(c->built);
+    c->built = NULL;
+  }
+}
+
+static void runToCsr(void *context) {
+  MatrixCase *c = context;
+  c->built = toCsr(c->triplets);
+}
+
+static void runSpmv(void *context) {
+  MatrixCase *c = context;
+  spmv(c->csr, c->x, c->y);
+}
+
+/**
+ * Finds an element by walking the triplets in order, as the lab did before it had an index.
+ */
+static int scanTriplets(SparseMatrix *matrix, int row, int col, int *value) {
+  size_t k = 0;
+  for (; k < matrix->count; ++k) {
+    if (matrix->row[k] == row && matrix->col[k] == col) {
+      *value = matrix->value[k];
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static void runScan(void *context) {
+  MatrixCase *c = context;
+  size_t k = 0;
+  for (; k < SCAN_COUNT; ++k) {
+    c->found += scanTriplets(c->triplets, c->rows[k], c->cols[k], &c->values[k]);
+  }
+}
+
+static void runLookupCsr(void *context) {
+  MatrixCase *c = context;
+  size_t k = 0;
+  for (; k < LOOKUP_COUNT; ++k) {
+    c->found += lookupCsr(c->csr, c->rows[k], c->cols[k], &c->values[k]);
+  }
+}
+
+static void runLookupHash(void *context) {
+  MatrixCase *c = context;
+  size_t k = 0;
+  for (; k < LOOKUP_COUNT; ++k) {
+    c->found += lookupHash(c->index, c->rows[k], c->cols[k], &c->values[k]);
+  }
+}
+
+static void runLookupBatch(void *context) {
+  MatrixCase *c = context;
+  c->found += lookupBatch(c->csr, c->index, c->rows, c->cols, LOOKUP_COUNT, c->values);
+}
+
+/**
+ * Builds an `n` x `n` CSR matrix with the given nonzero count in every row and random columns.
+ * Short rows draw columns and drop repeats, rows of more than half the columns keep every column
+ * with the matching chance instead.
+ */
+static CsrMatrix *randomCsr(int n, const size_t *lengths, uint64_t *rng) {
+  size_t total = 0;
+  int row = 0;
+  for (; row < n; ++row) {
+    total += lengths[row];
+  }
+
+  CsrMatrix *csr = createCsr(n, n, total);
+  size_t at = 0;
+  for (row = 0; row < n; ++row) {
+    csr->rowStart[row] = at;
+    int *cols = csr->colIndex + at;
+    size_t count = 0;
+    if (2 * lengths[row] > (size_t)n) {
+      int col = 0;
+      for (; col < n; ++col) {
+        if (benchBelow(rng, (size_t)n) < lengths[row]) {
+          cols[count++] = col;
+        }
+      }
+    } else {
+      size_t k = 0;
+      for (; k < lengths[row]; ++k) {
+        cols[k] = (int)benchBelow(rng, (size_t)n);
+      }
+      qsort(cols, lengths[row], sizeof(*cols), compareInts);
+      for (k = 0; k < lengths[row]; ++k) {
+        if (!count || cols[count - 1] != cols[k]) {
+          cols[count++] = cols[k];
+        }
+      }
+    }
+
+    size_t k = 0;
+    for (; k < count; ++k) {
+      csr->values[at + k] = 1 + (int)benchBelow(rng, 9);
+    }
+    at += count;
+  }
+  csr->rowStart[n] = at;
+  return csr;
+}
+
+/**
+ * Row lengths of a kernel matrix: KERNEL_ROW_NONZEROS each, or `c / rank` for a shuffled rank with
+ * `c` picked for the same average, at most `n`.
+ */
+static size_t *rowLengths(int n, int powerLaw, uint64_t *rng) {
+  size_t *lengths = malloc((size_t)n * sizeof(*lengths));
+  double harmonic = 0.0;
+  int row = 0;
+  for (; row < n; ++row) {
+    harmonic += 1.0 / (row + 1);
+  }
+
+  int *ranks = malloc((size_t)n * sizeof(*ranks));
+  for (row = 0; row < n; ++row) {
+    ranks[row] = row;
+  }
+  benchShuffle(ranks, (size_t)n, rng);
+  for (row = 0; row < n; ++row) {
+    double length = powerLaw ? (double)KERNEL_ROW_NONZEROS * n / harmonic / (ranks[row] + 1) : KERNEL_ROW_NONZEROS;
+    lengths[row] = length > n ? (size_t)n : length < 1 ? 1 : (size_t)length;
+  }
+
+  free(ranks);
+  return lengths;
+}
+
+typedef struct {
+  CsrMatrix *a;
+  CsrMatrix *b;
+  CsrMatrix *result;
+  double *x;
+  double *y;
+} KernelCase;
+
+static void prepareResult(void *context) {
+  KernelCase *c = context;
+  if (c->result) {
+    freeCsr(c->result);
+    c->result = NULL;
+  }
+}
+
+static void runKernelSpmv(void *context) {
+  KernelCase *c = context;
+  spmv(c->a, c->x, c->y);
+}
+
+static void runKernelSpmm(void *context) {
+  KernelCase *c = context;
+  spmm(c->a, c->x, SPMM_WIDTH, c->y);
+}
+
+static void runTranspose(void *context) {
+  KernelCase *c = context;
+  c->result = transposeCsr(c->a);
+}
+
+static void runAdd(void *context) {
+  KernelCase *c = context;
+  c->result = addCsr(c->a, c->b);
+}
+
+static void runMultiply(void *context) {
+  KernelCase *c = context;
+  c->result = multiplyCsr(c->a, c->a);
+}
+
+/**
+ * Times every kernel on one generated matrix. `b` is the transpose of `a`, so the sum merges rows
+ * of different shapes.
+ */
+static void runKernels(Bench *bench, const char *input, int n, int powerLaw, uint64_t *rng) {
+  size_t *lengths = rowLengths(n, powerLaw, rng);
+  KernelCase c;
+  c.a = randomCsr(n, lengths, rng);
+  c.b = transposeCsr(c.a);
+  c.result = NULL;
+  c.x = malloc((size_t)n * SPMM_WIDTH * sizeof(double));
+  c.y = malloc((size_t)n * SPMM_WIDTH * sizeof(double));
+  size_t i = 0;
+  for (; i < (size_t)n * SPMM_WIDTH; ++i) {
+    c.x[i] = 1.0 + benchBelow(rng, 100) / 100.0;
+  }
+
+  double rows = n;
+  double nnz = (double)c.a->rowStart[n];
+  double entry = sizeof(int) + sizeof(int);
+  double starts = (rows + 1) * sizeof(size_t);
+
+  bench->flops = 2 * nnz;
+  bench->bytes = nnz * entry + starts + 2 * rows * sizeof(double);
+  benchRun(bench, "spmv", input, (size_t)n, NULL, runKernelSpmv, &c);
+
+  bench->flops = 2 * nnz * SPMM_WIDTH;
+  bench->bytes = nnz * entry + starts + 2 * rows * SPMM_WIDTH * sizeof(double);
+  benchRun(bench, "spmm", input, (size_t)n, NULL, runKernelSpmm, &c);
+
+  bench->bytes = 2 * (nnz * entry + starts);
+  benchRun(bench, "transpose", input, (size_t)n, prepareResult, runTranspose, &c);
+
+  /* Result sizes are known up front, the sum and product are worked out once untimed. */
+  if (benchWants(bench, "add")) {
+    CsrMatrix *sum = addCsr(c.a, c.b);
+    double merged = (double)sum->rowStart[n];
+    bench->flops = 2 * nnz - merged;
+    bench->bytes = 2 * nnz * entry + 2 * starts + merged * entry + starts;
+    freeCsr(sum);
+    benchRun(bench, "add", input, (size_t)n, prepareResult, runAdd, &c);
+  }
+
+  if (benchWants(bench, "multiply")) {
+    double products = 0;
+    size_t k = 0;
+    for (; k < c.a->rowStart[n]; ++k) {
+      int inner = c.a->colIndex[k];
+      products += (double)(c.a->rowStart[inner + 1] - c.a->rowStart[inner]);
+    }
+    CsrMatrix *product = multiplyCsr(c.a, c.a);
+    double kept = (double)product->rowStart[n];
+    bench->flops = 2 * products;
+    bench->bytes = nnz * entry + starts + products * entry + kept * entry + starts;
+    freeCsr(product);
+    benchRun(bench, "multiply", input, (size_t)n, prepareResult, runMultiply, &c);
+  }
+
+  /* Keeps the results alive, stdout goes to the null device. */
+  printf("%f\n", c.y[0]);
+  prepareResult(&c);
+  freeCsr(c.a);
+  freeCsr(c.b);
+  free(c.x);
+  free(c.y);
+  free(lengths);
+}
+
+int main(int argc, char *argv[]) {
+  static const size_t sizes[] = {256, 1024, 4096};
+  static const char *inputs[] = {"random-1%", "random-10%", "banded", "full"};
+  Bench bench;
+  benchInit(&bench, "lab1", argc, argv);
+  benchSizes(&bench, sizes, sizeof(sizes) / sizeof(*sizes));
+
+  size_t s = 0;
+  for (; s < bench.sizeCount; ++s) {
+    size_t n = bench.sizes[s];
+    int shape = 0;
+    for (; shape < 4; ++shape) {
+      uint64_t rng = benchStream(&bench, s * 16 + shape);
+      MatrixCase c;
+      c.n = (int)n;
+      c.dense = malloc(n * n * sizeof(int));
+      c.x = malloc(n * sizeof(double));
+      c.y = malloc(n * sizeof(double));
+      c.converted = NULL;
+      c.built = NULL;
+      size_t i = 0, j;
+      for (; i < n; ++i) {
+        c.x[i] = 1.0 + benchBelow(&rng, 100) / 100.0;
+        for (j = 0; j < n; ++j) {
+          int nonzero = shape == 0 ? benchBelow(&rng, 100) == 0
+                      : shape == 1 ? benchBelow(&rng, 10) == 0
+                      : shape == 2 ? i <= j + 2 && j <= i + 2 : 1;
+          c.dense[i * n + j] = nonzero ? 1 + (int)benchBelow(&rng, 99) : 0;
+        }
+      }
+
+      benchRun(&bench, "fromDense", inputs[shape], n, prepareFromDense, runFromDense, &c);
+      c.triplets = fromDense(c.dense, c.n, c.n);
+      benchRun(&bench, "toCsr", inputs[shape], n, prepareToCsr, runToCsr, &c);
+      c.csr = toCsr(c.triplets);
+      benchRun(&bench, "spmv", inputs[shape], n, NULL, runSpmv, &c);
+
+      if (benchWants(&bench, "lookupScan") || benchWants(&bench, "lookupCsr") ||
+          benchWants(&bench, "lookupHash") || benchWants(&bench, "lookupBatch")) {
+        c.rows = malloc(LOOKUP_COUNT * sizeof(int));
+        c.cols = malloc(LOOKUP_COUNT * sizeof(int));
+        c.values = malloc(LOOKUP_COUNT * sizeof(int));
+        c.found = 0;
+        size_t k = 0;
+        for (; k < LOOKUP_COUNT; ++k) {
+          if (k % 2 && c.triplets->count) {
+            size_t at = benchBelow(&rng, c.triplets->count);
+            c.rows[k] = c.triplets->row[at];
+            c.cols[k] = c.triplets->col[at];
+          } else {
+            c.rows[k] = (int)benchBelow(&rng, n);
+            c.cols[k] = (int)benchBelow(&rng, n);
+          }
+        }
+        c.index = createHashIndex(c.csr);
+
+        bench.items = SCAN_COUNT;
+        benchRun(&bench, "lookupScan", inputs[shape], n, NULL, runScan, &c);
+        bench.items = LOOKUP_COUNT;
+        benchRun(&bench, "lookupCsr", inputs[shape], n, NULL, runLookupCsr, &c);
+        bench.items = LOOKUP_COUNT;
+        benchRun(&bench, "lookupHash", inputs[shape], n, NULL, runLookupHash, &c);
+        bench.items = LOOKUP_COUNT;
+        benchRun(&bench, "lookupBatch", inputs[shape], n, NULL, runLookupBatch, &c);
+
+        printf("%llu\n", (unsigned long long)c.found);
+        freeHashIndex(c.index);
+        free(c.rows);
+        free(c.cols);
+        free(c.values);
+      }
+
+      /* Keeps the results alive, stdout goes to the null device. */
+      printf("%f\n", c.y[n / 2]);
+      prepareFromDense(&c);
+      prepareToCsr(&c);
+      freeCsr(c.csr);
+      freeSparseMatrix(c.triplets);
+      free(c.dense);
+      free(c.x);
+      free(c.y);
+    }
+  }
+
+  static const char *kernelInputs[] = {"uniform", "power-law"};
+  for (s = 0; s < bench.sizeCount; ++s) {
+    int shape = 0;
+    for (; shape < 2; ++shape) {
+      uint64_t rng = benchStream(&bench, s * 16 + 8 + shape);
+      runKernels(&bench, kernelInputs[shape], (int)(bench.sizes[s] * KERNEL_SCALE), shape, &rng);
+    }
+  }
+
+  benchFinish(&bench);
+  return 0;
+}
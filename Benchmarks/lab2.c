@@ -0,0 +1,87 @@
+#include "bench.h"
+#include "../Labs/Lab_2.c"
+
+/*
+ * Lab 2: arithmetic on numbers held as digit lists, lowest digit first. Operands have `size`
+ * digits each, random or all nines, where every limb of a sum carries.
+ */
+
+typedef struct {
+  Node *l1;
+  Node *l2;
+  BigNumber *a;
+  BigNumber *b;
+  BigNumber *result;
+} NumberCase;
+
+static void prepareResult(void *context) {
+  NumberCase *c = context;
+  freeBigNumber(c->result);
+  c->result = NULL;
+}
+
+static void runFromList(void *context) {
+  NumberCase *c = context;
+  c->result = fromList(c->l1);
+}
+
+static void runAddLists(void *context) {
+  NumberCase *c = context;
+  c->result = addLinkedLists(c->l1, c->l2);
+}
+
+static void runAdd(void *context) {
+  NumberCase *c = context;
+  c->result = addBigNumbers(c->a, c->b);
+}
+
+static void runMultiply(void *context) {
+  NumberCase *c = context;
+  c->result = multiplyBigNumbers(c->a, c->b);
+}
+
+int main(int argc, char *argv[]) {
+  static const size_t sizes[] = {1000, 10000, 100000};
+  static const char *inputs[] = {"random", "nines"};
+  Bench bench;
+  benchInit(&bench, "lab2", argc, argv);
+  benchSizes(&bench, sizes, sizeof(sizes) / sizeof(*sizes));
+
+  size_t s = 0;
+  for (; s < bench.sizeCount; ++s) {
+    size_t n = bench.sizes[s];
+    int *digits = malloc(n * sizeof(int));
+    int nines = 0;
+    for (; nines < 2; ++nines) {
+      uint64_t rng = benchStream(&bench, s * 16 + nines);
+      NumberCase c = {NULL, NULL, NULL, NULL, NULL};
+      size_t i;
+      benchDigits(digits, n, nines, &rng);
+      for (i = 0; i < n; ++i) {
+        push(&c.l1, digits[i]);
+      }
+      benchDigits(digits, n, nines, &rng);
+      for (i = 0; i < n; ++i) {
+        push(&c.l2, digits[i]);
+      }
+      c.a = fromList(c.l1);
+      c.b = fromList(c.l2);
+
+      benchRun(&bench, "fromList", inputs[nines], n, prepareResult, runFromList, &c);
+      benchRun(&bench, "addLinkedLists", inputs[nines], n, prepareResult, runAddLists, &c);
+      benchRun(&bench, "addBigNumbers", inputs[nines], n, prepareResult, runAdd, &c);
+      benchRun(&bench, "multiplyBigNumbers", inputs[nines], n, prepareResult, runMultiply, &c);
+
+      prepareResult(&c);
+      freeBigNumber(c.a);
+      freeBigNumber(c.b);
+      freeList(c.l1);
+      freeList(c.l2);
+    }
+    free(digits);
+  }
+
+  releaseNodes();
+  benchFinish(&bench);
+  return 0;
+}
@@ -0,0 +1,106 @@
+#include "bench.h"
+#include "../Labs/Lab_3.c"
+
+/*
+ * Lab 3: adding two `size` digit numbers, random or all nines. The queue adder reads both queues
+ * in place; they are filled half a queue past their start so their contents wrap around the ring.
+ * The streaming adder reads the numbers from a temporary file, once within the default memory
+ * budget and once with a budget small enough that both spill buffers go to disk.
+ */
+
+typedef struct {
+  queue *q1;
+  queue *q2;
+  int *sum;
+  FILE *in;
+  size_t budget;
+} AdderCase;
+
+static void runQueues(void *context) {
+  AdderCase *c = context;
+  addDigitQueues(c->sum, c->q1, c->q2);
+}
+
+static void prepareStream(void *context) {
+  AdderCase *c = context;
+  rewind(c->in);
+}
+
+static void runStream(void *context) {
+  AdderCase *c = context;
+  streamAdd(c->in, stdout, c->budget);
+}
+
+/**
+ * Creates a queue holding the digits, with its start moved half the count into the ring.
+ */
+static queue *digitQueue(const int *digits, size_t n) {
+  queue *q = createQueue((int)n);
+  enq_n(q, digits, (unsigned)(n / 2));
+  deq_n(q, NULL, (unsigned)(n / 2));
+  enq_n(q, digits, (unsigned)n);
+  return q;
+}
+
+/**
+ * Writes a number in the streaming adder's input format: digit count, then the digits lowest first.
+ */
+static void writeNumber(FILE *fp, const int *digits, size_t n) {
+  fprintf(fp, "%llu\n", (unsigned long long)n);
+  size_t i = 0;
+  for (; i < n; ++i) {
+    fputc('0' + digits[i], fp);
+    fputc(' ', fp);
+  }
+  fputc('\n', fp);
+}
+
+int main(int argc, char *argv[]) {
+  static const size_t sizes[] = {1000, 100000, 1000000};
+  static const char *inputs[] = {"random", "nines"};
+  Bench bench;
+  benchInit(&bench, "lab3", argc, argv);
+  benchSizes(&bench, sizes, sizeof(sizes) / sizeof(*sizes));
+
+  size_t s = 0;
+  for (; s < bench.sizeCount; ++s) {
+    size_t n = bench.sizes[s];
+    int *a = malloc(n * sizeof(int));
+    int *b = malloc(n * sizeof(int));
+    int nines = 0;
+    for (; nines < 2; ++nines) {
+      uint64_t rng = benchStream(&bench, s * 16 + nines);
+      benchDigits(a, n, nines, &rng);
+      benchDigits(b, n, nines, &rng);
+
+      AdderCase c;
+      c.q1 = digitQueue(a, n);
+      c.q2 = digitQueue(b, n);
+      c.sum = malloc(n * sizeof(int));
+      benchRun(&bench, "addDigitQueues", inputs[nines], n, NULL, runQueues, &c);
+      freeQueue(c.q1);
+      freeQueue(c.q2);
+      free(c.sum);
+
+      if (benchWants(&bench, "streamAdd")) {
+        c.in = tmpfile();
+        if (!c.in) {
+          fputs("Cannot create a temporary file.\n", stderr);
+          exit(EXIT_FAILURE);
+        }
+        writeNumber(c.in, a, n);
+        writeNumber(c.in, b, n);
+        c.budget = MEMORY_BUDGET;
+        benchRun(&bench, "streamAdd", inputs[nines], n, prepareStream, runStream, &c);
+        c.budget = 2 * CHUNK_DIGITS;
+        benchRun(&bench, "streamAddSpill", inputs[nines], n, prepareStream, runStream, &c);
+        fclose(c.in);
+      }
+    }
+    free(a);
+    free(b);
+  }
+
+  benchFinish(&bench);
+  return 0;
+}
@@ -0,0 +1,147 @@
+#include "bench.h"
+#include "../Labs/Lab_4.c"
+
+/*
+ * Lab 4: array trees of `size` slots. `findMax` runs on a complete BST and on one with random
+ * subtrees cut off (holes) away from the right spine. The lookups search `size` random keys, half
+ * of them present, in the Eytzinger tree, the succinct tree and the dynamic set. The dynamic set is
+ * also filled from scratch with its keys in random, sorted and reversed order.
+ */
+
+typedef struct {
+  int *tree;
+  size_t N;
+  SearchTree *search;
+  SuccinctTree *succinct;
+  DynamicSet *set;
+  int *keys;
+  int *queries;
+  size_t *results;
+  size_t sink;
+} TreeCase;
+
+static void runFindMax(void *context) {
+  TreeCase *c = context;
+  findMax(c->tree, c->N);
+}
+
+static void runLowerBound(void *context) {
+  TreeCase *c = context;
+  size_t i = 0;
+  for (; i < c->N; ++i) {
+    c->sink += searchLowerBound(c->search, c->queries[i]);
+  }
+}
+
+static void runLowerBoundBatch(void *context) {
+  TreeCase *c = context;
+  searchLowerBoundBatch(c->search, c->queries, c->N, c->results);
+  c->sink += c->results[c->N / 2];
+}
+
+static void runSuccinctFind(void *context) {
+  TreeCase *c = context;
+  size_t i = 0;
+  for (; i < c->N; ++i) {
+    c->sink += succinctFind(c->succinct, c->queries[i]);
+  }
+}
+
+static void runDynamicFind(void *context) {
+  TreeCase *c = context;
+  size_t i = 0;
+  for (; i < c->N; ++i) {
+    c->sink += dynamicFind(c->set, c->queries[i]);
+  }
+}
+
+static void prepareDynamicInsert(void *context) {
+  TreeCase *c = context;
+  freeDynamicSet(c->set);
+  c->set = NULL;
+}
+
+static void runDynamicInsert(void *context) {
+  TreeCase *c = context;
+  c->set = createDynamicSet();
+  size_t i = 0;
+  for (; i < c->N; ++i) {
+    dynamicInsert(c->set, c->keys[i]);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  static const size_t sizes[] = {1023, 65535, 1048575};
+  static const int shapes[] = {SHAPE_RANDOM, SHAPE_SORTED, SHAPE_REVERSED};
+  Bench bench;
+  benchInit(&bench, "lab4", argc, argv);
+  benchSizes(&bench, sizes, sizeof(sizes) / sizeof(*sizes));
+
+  size_t s = 0;
+  for (; s < bench.sizeCount; ++s) {
+    size_t N = bench.sizes[s];
+    uint64_t rng = benchStream(&bench, s);
+    TreeCase c;
+    c.N = N;
+    c.tree = malloc(N * sizeof(int));
+    c.keys = malloc(N * sizeof(int));
+    c.queries = malloc(N * sizeof(int));
+    c.results = malloc(N * sizeof(size_t));
+    c.set = NULL;
+    c.sink = 0;
+
+    /* Keys 1, 3, 5, ... in BST order: the Eytzinger layout of sorted keys is a complete BST. */
+    size_t i = 0;
+    for (; i < N; ++i) {
+      c.keys[i] = (int)(2 * i + 1);
+      c.queries[i] = (int)benchBelow(&rng, 2 * N + 1);
+    }
+    c.search = createSearchTree(c.keys, N);
+    memcpy(c.tree, c.search->keys, N * sizeof(int));
+    benchRun(&bench, "findMax", "complete", N, NULL, runFindMax, &c);
+
+    benchRun(&bench, "searchLowerBound", "random", N, NULL, runLowerBound, &c);
+    benchRun(&bench, "searchLowerBoundBatch", "random", N, NULL, runLowerBoundBatch, &c);
+    if (benchWants(&bench, "succinctFind")) {
+      c.succinct = createSuccinctTree(c.tree, N);
+      benchRun(&bench, "succinctFind", "random", N, NULL, runSuccinctFind, &c);
+      freeSuccinctTree(c.succinct);
+    }
+
+    /* Cut one subtree in eight off, except on the right spine (slots 2^k - 2). */
+    for (i = 1; i < N; ++i) {
+      int spine = ((i + 2) & (i + 1)) == 0;
+      if (c.tree[treeParent(i)] == -1 || (!spine && benchBelow(&rng, 8) == 0)) {
+        c.tree[i] = -1;
+      }
+    }
+    benchRun(&bench, "findMax", "sparse", N, NULL, runFindMax, &c);
+
+    size_t k = 0;
+    for (; k < sizeof(shapes) / sizeof(*shapes); ++k) {
+      benchKeys(c.keys, N, shapes[k], &rng);
+      for (i = 0; i < N; ++i) {
+        c.keys[i] = 2 * c.keys[i] + 1;
+      }
+      benchRun(&bench, "dynamicInsert", shapeName(shapes[k]), N, prepareDynamicInsert, runDynamicInsert, &c);
+    }
+    if (benchWants(&bench, "dynamicFind")) {
+      if (!c.set) {
+        runDynamicInsert(&c);
+      }
+      benchRun(&bench, "dynamicFind", "random", N, NULL, runDynamicFind, &c);
+    }
+
+    /* Keeps the results alive, stdout goes to the null device. */
+    printf("%llu\n", (unsigned long long)c.sink);
+    freeDynamicSet(c.set);
+    freeSearchTree(c.search);
+    free(c.tree);
+    free(c.keys);
+    free(c.queries);
+    free(c.results);
+  }
+
+  benchFinish(&bench);
+  return 0;
+}
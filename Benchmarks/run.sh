@@ -0,0 +1,72 @@
+#!/bin/sh
+# Builds every benchmark driver with -DBENCHMARK and runs them one after another.
+#
+# Usage: Benchmarks/run.sh [--format json|csv] [--out FILE] [--only "lab2 lab4"] [driver options]
+#
+# Other options (--size, --repeats, --warmup, --seed, --filter) are passed to every driver. The
+# compiler and flags come from CC and CFLAGS. The default flags hand the `simd` loop hints to the
+# compiler without threads; CFLAGS="-O2 -fopenmp" also builds the threaded paths.
+set -e
+
+cd "$(dirname "$0")"
+CC=${CC:-cc}
+CFLAGS=${CFLAGS:--O2 -fopenmp-simd -DOPENMP_SIMD}
+BUILD=build
+FORMAT=json
+OUT=
+PROGRAMS="assignment1 assignment2 assignment3 assignment4 lab1 lab2 lab3 lab4"
+LABEL=$(git describe --always --dirty 2>/dev/null || echo unknown)
+
+# Takes out the options of this script, the rest is rotated back into "$@" in order.
+left=$#
+while [ $left -gt 0 ]; do
+  option=$1
+  shift
+  left=$((left - 1))
+  case "$option" in
+    --format|--out|--only|--label)
+      if [ $left -eq 0 ]; then
+        echo "Missing value of $option." >&2
+        exit 1
+      fi
+      case "$option" in
+        --format) FORMAT=$1 ;;
+        --out) OUT=$1 ;;
+        --only) PROGRAMS=$1 ;;
+        --label) LABEL=$1 ;;
+      esac
+      shift
+      left=$((left - 1))
+      ;;
+    *) set -- "$@" "$option" ;;
+  esac
+done
+
+mkdir -p "$BUILD"
+for program in $PROGRAMS; do
+  # shellcheck disable=SC2086
+  $CC -std=c11 $CFLAGS -DBENCHMARK -o "$BUILD/$program" "$program.c"
+done
+
+run() {
+  first=1
+  for program in $PROGRAMS; do
+    echo "Running $program" >&2
+    if [ "$FORMAT" = csv ] && [ $first -eq 0 ]; then
+      "$BUILD/$program" --format "$FORMAT" --label "$LABEL" "$@" | tail -n +2
+    else
+      "$BUILD/$program" --format "$FORMAT" --label "$LABEL" "$@"
+    fi
+    first=0
+  done
+}
+
+if [ -n "$OUT" ]; then
+  case "$OUT" in
+    /*) ;;
+    *) OUT="$OLDPWD/$OUT" ;;
+  esac
+  run "$@" > "$OUT"
+else
+  run "$@"
+fi
@@ -1,73 +1,1160 @@
+/* Asks for `fileno` and `isatty`, see `createReader`. */
+#ifndef _WIN32
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#endif
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#ifdef _WIN32
+#include <io.h>
+#define fileno _fileno
+#define isatty _isatty
+#else
+#include <unistd.h>
+#endif
 
-int main() {
-  int n, m;
-  fputs("Enter dimensions:\n", stdout);
-  scanf(" %d %d", &n, &m);
-  int** matrix = calloc(n, sizeof(*matrix));
-  int i, j;
-  for (i = 0; i < n; ++i) {
-    matrix[i] = calloc(m, sizeof(**matrix));
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/*
+ * OpenMP directives are only handed to compilers that were asked for them: all of them with
+ * -fopenmp, the `simd` loop hints alone with -fopenmp-simd -DOPENMP_SIMD. Plain builds run the
+ * loops as written, without unknown pragma warnings.
+ */
+#if defined(_OPENMP) || defined(OPENMP_SIMD)
+#define OMP(directive) _Pragma(OMP_TEXT(omp directive))
+#define OMP_TEXT(text) #text
+#else
+#define OMP(directive)
+#endif
+
+/* Input is read in blocks of this size instead of one `scanf` call per value. */
+#define READ_BLOCK_SIZE (1 << 16)
+
+/* Room for this many nonzeros is allocated first, the buffer doubles when it fills up. */
+#define INITIAL_CAPACITY 16
+
+/* Triplets are sorted by comparison instead of counting once the buckets outnumber them this much. */
+#define COUNTING_SORT_RATIO 4
+
+/*
+ * Nonzero elements of a `rows` x `cols` matrix, sorted by row and then by column. Element `k` is
+ * `value[k]` at `row[k]`, `col[k]`, each field in its own contiguous array.
+ */
+typedef struct {
+  int rows;
+  int cols;
+  size_t count;
+  size_t capacity;
+  int *row;
+  int *col;
+  int *value;
+} SparseMatrix;
+
+/*
+ * Compressed sparse row form: the nonzeros of row `i` are at `rowStart[i]` up to (excluding)
+ * `rowStart[i + 1]`, with ascending column indices.
+ */
+typedef struct {
+  int rows;
+  int cols;
+  size_t *rowStart;
+  int *colIndex;
+  int *values;
+} CsrMatrix;
+
+/* Slot of a hash index, key and value side by side so a probe touches one cache line. */
+typedef struct {
+  uint64_t key;       /* Packed position plus one, 0 marks an empty slot. */
+  int value;
+} HashSlot;
+
+/* Open addressing hash table from element position to value, with linear probing. */
+typedef struct {
+  size_t mask;
+  HashSlot *slots;
+} HashIndex;
+
+/*
+ * Buffered reader of whitespace separated integers, `%` starts a comment until the end of line.
+ * Files and pipes are read in whole blocks, a terminal one line at a time so every line is used as
+ * soon as it is typed.
+ */
+typedef struct {
+  FILE *fp;
+  int interactive;
+  char *block;
+  size_t length;
+  size_t pos;
+} InputReader;
+
+InputReader *createReader(FILE *);
+void freeReader(InputReader *);
+int nextChar(InputReader *);
+int nextInt(InputReader *, long long *);
+int readIndex(InputReader *, int *);
+SparseMatrix *createSparseMatrix(int, int, size_t);
+void reserveTriplets(SparseMatrix *, size_t);
+void appendTriplet(SparseMatrix *, int, int, int);
+void freeSparseMatrix(SparseMatrix *);
+SparseMatrix *fromDense(const int *, int, int);
+void sortTriplets(SparseMatrix *);
+void mergeDuplicates(SparseMatrix *);
+SparseMatrix *readDense(InputReader *, int, int);
+SparseMatrix *readMarket(InputReader *);
+void printTriplets(SparseMatrix *);
+CsrMatrix *toCsr(SparseMatrix *);
+void freeCsr(CsrMatrix *);
+int lookupCsr(CsrMatrix *, int, int, int *);
+uint64_t packPosition(int, int);
+size_t hashPosition(uint64_t);
+HashIndex *createHashIndex(CsrMatrix *);
+void freeHashIndex(HashIndex *);
+int lookupHash(HashIndex *, int, int, int *);
+size_t lookupBatch(CsrMatrix *, HashIndex *, const int *, const int *, size_t, int *);
+CsrMatrix *createCsr(int, int, size_t);
+int rowBlockStart(CsrMatrix *, int, int);
+void spmv(CsrMatrix *, const double *, double *);
+void spmm(CsrMatrix *, const double *, size_t, double *);
+CsrMatrix *transposeCsr(CsrMatrix *);
+CsrMatrix *addCsr(CsrMatrix *, CsrMatrix *);
+CsrMatrix *multiplyCsr(CsrMatrix *, CsrMatrix *);
+int compareInts(const void *, const void *);
+int compareSlots(const void *, const void *);
+
+#ifndef BENCHMARK
+int main(int argc, char *argv[]) {
+  int market = 0;
+  int hash = 0;
+  int i = 1;
+  for (; i < argc; ++i) {
+    if (strcmp(argv[i], "--market") == 0) {
+      market = 1;
+    } else if (strcmp(argv[i], "--hash") == 0) {
+      hash = 1;
+    } else {
+      fprintf(stderr, "Unknown option %s.\n", argv[i]);
+      exit(EXIT_FAILURE);
+    }
   }
-  fputs("Enter data:\n", stdout);
-  for (i = 0; i < n; ++i) {
-    for (j = 0; j < m; ++j) {
-      int num;
-      scanf("%d", &num);
-      matrix[i][j] = num;
+
+  InputReader *reader = createReader(stdin);
+  SparseMatrix *n_mat;
+
+  if (market) {
+    n_mat = readMarket(reader);
+  } else {
+    int n, m;
+    fputs("Enter dimensions:\n", stdout);
+    if (!readIndex(reader, &n) || !readIndex(reader, &m)) {
+      fputs("Invalid dimensions.\n", stderr);
+      exit(EXIT_FAILURE);
     }
+    fputs("Enter data:\n", stdout);
+    n_mat = readDense(reader, n, m);
+  }
+
+  int search_x, search_y;
+  fputs("\nSearch elem:\n", stdout);
+  if (!readIndex(reader, &search_x) || !readIndex(reader, &search_y)) {
+    search_x = search_y = -1;
+  }
+
+  fputs("\nNew matrix:\n", stdout);
+  printTriplets(n_mat);
+
+  CsrMatrix *csr = toCsr(n_mat);
+  HashIndex *index = hash ? createHashIndex(csr) : NULL;
+
+  int search;
+  int found = index ? lookupHash(index, search_x, search_y, &search) : lookupCsr(csr, search_x, search_y, &search);
+  if (found) {
+    printf("\nSearched elem: %d", search);
   }
 
-  int non_zero = 0;
-  for (i = 0; i < n; ++i) {
-    for (j = 0; j < m; ++j) {
-      if (matrix[i][j] != 0) { ++non_zero; }
+  if (!found) { printf("\nNot found"); }
+
+  freeHashIndex(index);
+  freeCsr(csr);
+  freeSparseMatrix(n_mat);
+  freeReader(reader);
+  return 0;
+}
+#endif
+
+/**
+ * Creates a buffered integer reader over an open file.
+ *
+ * @param fp File to be read, not closed with the reader.
+ *
+ * @return Pointer to newly created InputReader object.
+ */
+InputReader *createReader(FILE *fp) {
+  InputReader *reader = malloc(sizeof(*reader));
+  reader->fp = fp;
+  reader->interactive = isatty(fileno(fp));
+  reader->block = malloc(READ_BLOCK_SIZE);
+  reader->length = 0;
+  reader->pos = 0;
+
+  return reader;
+}
+
+/**
+ * Frees a reader and its block.
+ *
+ * @param reader Pointer to reader object to be freed.
+ */
+void freeReader(InputReader *reader) {
+  free(reader->block);
+  free(reader);
+}
+
+/**
+ * Returns the next character of the input, reading a new block, or a new line from a terminal,
+ * when the current one is used up.
+ *
+ * @param reader Pointer to reader object.
+ *
+ * @return Next character, EOF at the end of input.
+ */
+int nextChar(InputReader *reader) {
+  if (reader->pos == reader->length) {
+    if (reader->interactive) {
+      reader->length = fgets(reader->block, READ_BLOCK_SIZE, reader->fp) ? strlen(reader->block) : 0;
+    } else {
+      reader->length = fread(reader->block, 1, READ_BLOCK_SIZE, reader->fp);
+    }
+    reader->pos = 0;
+    if (!reader->length) {
+      return EOF;
+    }
+  }
+  return (unsigned char)reader->block[reader->pos++];
+}
+
+/**
+ * Reads the next integer of the input, skipping whitespace and comments before it.
+ *
+ * @param reader Pointer to reader object.
+ * @param[out] value Integer that was read.
+ *
+ * @return True if an integer was read, false at the end of input or on a character that is not part of one.
+ */
+int nextInt(InputReader *reader, long long *value) {
+  int c = nextChar(reader);
+  while (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '%') {
+    if (c == '%') {
+      while (c != '\n' && c != EOF) {
+        c = nextChar(reader);
+      }
     }
+    c = nextChar(reader);
   }
 
-  int** n_mat = calloc(non_zero, sizeof(*n_mat));
-  for (i = 0; i < non_zero; ++i) {
-    n_mat[i] = calloc(3, sizeof(**n_mat));
+  int negative = (c == '-');
+  if (c == '-' || c == '+') {
+    c = nextChar(reader);
+  }
+  if (c < '0' || c > '9') {
+    return 0;
   }
 
-  int search, search_x, search_y;
-  fputs("\nSearch elem:\n", stdout);
-  scanf("%d %d", &search_x, &search_y);
+  long long result = 0;
+  while (c >= '0' && c <= '9') {
+    result = result * 10 + (c - '0');
+    c = nextChar(reader);
+  }
+  *value = negative ? -result : result;
+  return 1;
+}
+
+/**
+ * Reads the next integer of the input as a non-negative `int`, used for dimensions and coordinates.
+ *
+ * @param reader Pointer to reader object.
+ * @param[out] value Integer that was read.
+ *
+ * @return True if a valid index was read, false if not.
+ */
+int readIndex(InputReader *reader, int *value) {
+  long long temp;
+  if (!nextInt(reader, &temp) || temp < 0 || temp > 0x7FFFFFFF) {
+    return 0;
+  }
+  *value = (int)temp;
+  return 1;
+}
+
+/**
+ * Creates an empty sparse matrix.
+ *
+ * @param rows, cols Dimensions of the matrix.
+ * @param capacity Number of nonzeros to make room for, grows later if needed.
+ *
+ * @return Pointer to newly created SparseMatrix object.
+ */
+SparseMatrix *createSparseMatrix(int rows, int cols, size_t capacity) {
+  SparseMatrix *matrix = malloc(sizeof(*matrix));
+  matrix->rows = rows;
+  matrix->cols = cols;
+  matrix->count = 0;
+  matrix->capacity = 0;
+  matrix->row = NULL;
+  matrix->col = NULL;
+  matrix->value = NULL;
+  reserveTriplets(matrix, capacity ? capacity : INITIAL_CAPACITY);
+
+  return matrix;
+}
+
+/**
+ * Resizes the element arrays of a sparse matrix to hold given number of nonzeros.
+ *
+ * @param matrix Pointer to sparse matrix object.
+ * @param capacity New capacity, not less than `matrix->count`.
+ */
+void reserveTriplets(SparseMatrix *matrix, size_t capacity) {
+  matrix->row = realloc(matrix->row, capacity * sizeof(*matrix->row));
+  matrix->col = realloc(matrix->col, capacity * sizeof(*matrix->col));
+  matrix->value = realloc(matrix->value, capacity * sizeof(*matrix->value));
+  if (!matrix->row || !matrix->col || !matrix->value) {
+    fputs("Out of memory.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+  matrix->capacity = capacity;
+}
+
+/**
+ * Appends a nonzero element, doubling the buffer if it is full.
+ *
+ * @param matrix Pointer to sparse matrix object.
+ * @param row, col Position of the element.
+ * @param value Value of the element.
+ */
+void appendTriplet(SparseMatrix *matrix, int row, int col, int value) {
+  if (matrix->count == matrix->capacity) {
+    reserveTriplets(matrix, 2 * matrix->capacity);
+  }
+
+  matrix->row[matrix->count] = row;
+  matrix->col[matrix->count] = col;
+  matrix->value[matrix->count] = value;
+  ++matrix->count;
+}
+
+/**
+ * Frees a sparse matrix and its elements.
+ *
+ * @param matrix Pointer to sparse matrix object to be freed.
+ */
+void freeSparseMatrix(SparseMatrix *matrix) {
+  free(matrix->row);
+  free(matrix->col);
+  free(matrix->value);
+  free(matrix);
+}
+
+/**
+ * Converts a dense matrix in memory to triplets in three passes that each run on OpenMP threads:
+ * rows count their nonzeros, a prefix sum turns the counts into write positions, and rows scatter
+ * their nonzeros there. The result is allocated exactly and comes out sorted.
+ *
+ * @param dense Matrix stored row by row, `rows * cols` values.
+ * @param rows, cols Dimensions of the matrix.
+ *
+ * @return Pointer to newly created SparseMatrix object.
+ */
+SparseMatrix *fromDense(const int *dense, int rows, int cols) {
+  size_t *starts = calloc((size_t)rows + 1, sizeof(*starts));
+  if (!starts) {
+    fputs("Out of memory.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+
+  long long i;
+  OMP(parallel for schedule(static))
+  for (i = 0; i < rows; ++i) {
+    const int *line = dense + (size_t)i * cols;
+    size_t count = 0;
+    int j = 0;
+    for (; j < cols; ++j) {
+      count += (line[j] != 0);
+    }
+    starts[i + 1] = count;
+  }
+  for (i = 0; i < rows; ++i) {
+    starts[i + 1] += starts[i];
+  }
+
+  SparseMatrix *matrix = createSparseMatrix(rows, cols, starts[rows]);
+  matrix->count = starts[rows];
+
+  OMP(parallel for schedule(static))
+  for (i = 0; i < rows; ++i) {
+    const int *line = dense + (size_t)i * cols;
+    size_t at = starts[i];
+
+    /* Writes every value and only keeps nonzeros by moving on, stops before running into the next row. */
+    int j = 0;
+    for (; j < cols && at < starts[i + 1]; ++j) {
+      matrix->row[at] = (int)i;
+      matrix->col[at] = j;
+      matrix->value[at] = line[j];
+      at += (line[j] != 0);
+    }
+  }
 
-  size_t idx = 0;
-  for (i = 0; i < n; ++i) {
-    for (j = 0; j < m; ++j) {
-      if (i == search_x && j == search_y) {
-        search = matrix[i][j];
+  free(starts);
+  return matrix;
+}
+
+/**
+ * Sorts the elements by row and then by column with two stable counting sorts, first on columns
+ * and then on rows. When the dimensions are far larger than the nonzero count, the buckets would
+ * cost more than the elements, so the packed positions are sorted with `qsort` instead.
+ *
+ * @param matrix Pointer to sparse matrix object to be sorted.
+ */
+void sortTriplets(SparseMatrix *matrix) {
+  size_t count = matrix->count ? matrix->count : 1;
+  size_t buckets = (size_t)(matrix->rows > matrix->cols ? matrix->rows : matrix->cols) + 1;
+  if (buckets / COUNTING_SORT_RATIO > count) {
+    HashSlot *slots = malloc(count * sizeof(*slots));
+    if (!slots) {
+      fputs("Out of memory.\n", stderr);
+      exit(EXIT_FAILURE);
+    }
+
+    size_t k = 0;
+    for (; k < matrix->count; ++k) {
+      slots[k].key = packPosition(matrix->row[k], matrix->col[k]);
+      slots[k].value = matrix->value[k];
+    }
+    qsort(slots, matrix->count, sizeof(*slots), compareSlots);
+    for (k = 0; k < matrix->count; ++k) {
+      matrix->row[k] = (int)((slots[k].key - 1) >> 32);
+      matrix->col[k] = (int)(uint32_t)(slots[k].key - 1);
+      matrix->value[k] = slots[k].value;
+    }
+
+    free(slots);
+    return;
+  }
+
+  size_t *starts = malloc(buckets * sizeof(*starts));
+  int *row = malloc(count * sizeof(*row));
+  int *col = malloc(count * sizeof(*col));
+  int *value = malloc(count * sizeof(*value));
+  if (!starts || !row || !col || !value) {
+    fputs("Out of memory.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+
+  int pass = 0;
+  for (; pass < 2; ++pass) {
+    const int *key = pass ? matrix->row : matrix->col;
+    memset(starts, 0, buckets * sizeof(*starts));
+
+    size_t k = 0;
+    for (; k < matrix->count; ++k) {
+      ++starts[key[k] + 1];
+    }
+    for (k = 1; k < buckets; ++k) {
+      starts[k] += starts[k - 1];
+    }
+    for (k = 0; k < matrix->count; ++k) {
+      size_t at = starts[key[k]]++;
+      row[at] = matrix->row[k];
+      col[at] = matrix->col[k];
+      value[at] = matrix->value[k];
+    }
+
+    int *temp = matrix->row;
+    matrix->row = row;
+    row = temp;
+    temp = matrix->col;
+    matrix->col = col;
+    col = temp;
+    temp = matrix->value;
+    matrix->value = value;
+    value = temp;
+  }
+
+  free(starts);
+  free(row);
+  free(col);
+  free(value);
+}
+
+/**
+ * Sums the elements of sorted triplets that share a position into one, so every lookup path sees a
+ * single value per position. Sums wrap like `int` arithmetic and those that cancel out to 0 are
+ * dropped.
+ *
+ * @param matrix Pointer to sparse matrix object, sorted by row and then by column.
+ */
+void mergeDuplicates(SparseMatrix *matrix) {
+  size_t at = 0;
+  size_t k = 0;
+  while (k < matrix->count) {
+    int row = matrix->row[k];
+    int col = matrix->col[k];
+    unsigned sum = (unsigned)matrix->value[k++];
+    while (k < matrix->count && matrix->row[k] == row && matrix->col[k] == col) {
+      sum += (unsigned)matrix->value[k++];
+    }
+
+    if (sum != 0) {
+      matrix->row[at] = row;
+      matrix->col[at] = col;
+      matrix->value[at] = (int)sum;
+      ++at;
+    }
+  }
+  matrix->count = at;
+}
+
+/**
+ * Reads a dense `rows` x `cols` matrix row by row and keeps only its nonzeros, so memory grows with
+ * the nonzero count and never with the full matrix. Values missing at the end of input count as 0.
+ *
+ * @param reader Pointer to reader object.
+ * @param rows, cols Dimensions of the matrix.
+ *
+ * @return Pointer to newly created SparseMatrix object.
+ */
+SparseMatrix *readDense(InputReader *reader, int rows, int cols) {
+  SparseMatrix *matrix = createSparseMatrix(rows, cols, 0);
+
+  int i, j;
+  for (i = 0; i < rows; ++i) {
+    for (j = 0; j < cols; ++j) {
+      long long num;
+      if (!nextInt(reader, &num)) {
+        return matrix;
       }
-      if (matrix[i][j] != 0) {
-        n_mat[idx][0] = i;
-        n_mat[idx][1] = j;
-        n_mat[idx][2] = matrix[i][j];
-        ++idx;
+      if (num != 0) {
+        appendTriplet(matrix, i, j, (int)num);
       }
     }
   }
 
-  fputs("\nNew matrix:\n", stdout);
-  for (i = 0; i < non_zero; ++i) {
-    for (j = 0; j < 3; ++j) {
-      printf("%d ", n_mat[i][j]);
+  return matrix;
+}
+
+/**
+ * Reads a matrix in coordinate form, like Matrix Market files: comment lines start with `%`, then
+ * a `rows cols count` line and `count` lines of `row col value` with 1-based positions.
+ * Zero values are dropped, elements are sorted if they are not given in row order and elements
+ * repeating a position are summed into one.
+ *
+ * @param reader Pointer to reader object.
+ *
+ * @return Pointer to newly created SparseMatrix object.
+ */
+SparseMatrix *readMarket(InputReader *reader) {
+  int rows, cols;
+  long long count;
+  if (!readIndex(reader, &rows) || !readIndex(reader, &cols) || !nextInt(reader, &count) || count < 0) {
+    fputs("Invalid matrix header.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+
+  SparseMatrix *matrix = createSparseMatrix(rows, cols, (size_t)count);
+  int sorted = 1;
+
+  long long k = 0;
+  for (; k < count; ++k) {
+    long long row, col, value;
+    if (!nextInt(reader, &row) || !nextInt(reader, &col) || !nextInt(reader, &value)) {
+      fputs("Missing matrix elements.\n", stderr);
+      exit(EXIT_FAILURE);
+    }
+    if (row < 1 || row > rows || col < 1 || col > cols) {
+      fprintf(stderr, "Element %lld %lld is out of range.\n", row, col);
+      exit(EXIT_FAILURE);
+    }
+    if (value == 0) {
+      continue;
+    }
+
+    if (matrix->count) {
+      long long lastRow = matrix->row[matrix->count - 1];
+      long long lastCol = matrix->col[matrix->count - 1];
+      sorted = sorted && (lastRow < row - 1 || (lastRow == row - 1 && lastCol < col - 1));
+    }
+    appendTriplet(matrix, (int)row - 1, (int)col - 1, (int)value);
+  }
+
+  if (!sorted) {
+    sortTriplets(matrix);
+    mergeDuplicates(matrix);
+  }
+
+  return matrix;
+}
+
+/**
+ * Prints every nonzero as a `row col value` line.
+ *
+ * @param matrix Pointer to sparse matrix object to be printed.
+ */
+void printTriplets(SparseMatrix *matrix) {
+  size_t i = 0;
+  for (; i < matrix->count; ++i) {
+    printf("%d %d %d \n", matrix->row[i], matrix->col[i], matrix->value[i]);
+  }
+}
+
+/**
+ * Converts sorted triplets to compressed sparse row form.
+ *
+ * @param matrix Pointer to sparse matrix object, sorted by row and then by column.
+ *
+ * @return Pointer to newly created CsrMatrix object.
+ */
+CsrMatrix *toCsr(SparseMatrix *matrix) {
+  CsrMatrix *csr = createCsr(matrix->rows, matrix->cols, matrix->count);
+
+  memcpy(csr->colIndex, matrix->col, matrix->count * sizeof(*csr->colIndex));
+  memcpy(csr->values, matrix->value, matrix->count * sizeof(*csr->values));
+
+  size_t i = 0;
+  for (; i < matrix->count; ++i) {
+    ++csr->rowStart[matrix->row[i] + 1];
+  }
+  int row = 0;
+  for (; row < matrix->rows; ++row) {
+    csr->rowStart[row + 1] += csr->rowStart[row];
+  }
+
+  return csr;
+}
+
+/**
+ * Frees a matrix in compressed sparse row form.
+ *
+ * @param csr Pointer to CSR matrix object to be freed.
+ */
+void freeCsr(CsrMatrix *csr) {
+  free(csr->rowStart);
+  free(csr->colIndex);
+  free(csr->values);
+  free(csr);
+}
+
+/**
+ * Finds an element by binary searching the column indices of its row.
+ *
+ * @param csr Pointer to CSR matrix object.
+ * @param row, col Position of the element, may be out of range.
+ * @param[out] value Value of the element if it is a nonzero.
+ *
+ * @return True if the element is a nonzero, false if it is 0 or out of range.
+ */
+int lookupCsr(CsrMatrix *csr, int row, int col, int *value) {
+  if (row < 0 || row >= csr->rows || col < 0 || col >= csr->cols) {
+    return 0;
+  }
+
+  size_t low = csr->rowStart[row];
+  size_t high = csr->rowStart[row + 1];
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (csr->colIndex[mid] < col) {
+      low = mid + 1;
+    } else {
+      high = mid;
     }
-    fputc('\n', stdout);
   }
 
-  int found = 0;
+  if (low < csr->rowStart[row + 1] && csr->colIndex[low] == col) {
+    *value = csr->values[low];
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * Packs a position into one hash key. Never returns 0, which marks empty slots.
+ *
+ * @param row, col Position of the element, must be in range.
+ *
+ * @return Key of the position.
+ */
+uint64_t packPosition(int row, int col) {
+  return (((uint64_t)row << 32) | (uint32_t)col) + 1;
+}
+
+/**
+ * Mixes the bits of a key so nearby positions spread over the table (a 64-bit finalizer).
+ *
+ * @param key Key to be hashed.
+ *
+ * @return Hash of the key.
+ */
+size_t hashPosition(uint64_t key) {
+  key ^= key >> 33;
+  key *= UINT64_C(0xff51afd7ed558ccd);
+  key ^= key >> 33;
+  key *= UINT64_C(0xc4ceb9fe1a85ec53);
+  key ^= key >> 33;
+  return (size_t)key;
+}
 
-  for (i = 0; i < non_zero; ++i) {
-    if (n_mat[i][0] == search_x && n_mat[i][1] == search_y) {
-      printf("\nSearched elem: %d", n_mat[i][2]);
-      found = 1;
+/**
+ * Creates a hash index over every nonzero of a matrix, for lookups that do not depend on row length.
+ * The table is kept at most two thirds full.
+ *
+ * @param csr Pointer to CSR matrix object to be indexed.
+ *
+ * @return Pointer to newly created HashIndex object.
+ */
+HashIndex *createHashIndex(CsrMatrix *csr) {
+  size_t count = csr->rowStart[csr->rows];
+  size_t size = 16;
+  while (size < count + count / 2) {
+    size *= 2;
+  }
+
+  HashIndex *index = malloc(sizeof(*index));
+  index->mask = size - 1;
+  index->slots = calloc(size, sizeof(*index->slots));
+  if (!index->slots) {
+    fputs("Out of memory.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+
+  int row = 0;
+  for (; row < csr->rows; ++row) {
+    size_t k = csr->rowStart[row];
+    for (; k < csr->rowStart[row + 1]; ++k) {
+      uint64_t key = packPosition(row, csr->colIndex[k]);
+      size_t slot = hashPosition(key) & index->mask;
+      while (index->slots[slot].key && index->slots[slot].key != key) {
+        slot = (slot + 1) & index->mask;
+      }
+      index->slots[slot].key = key;
+      index->slots[slot].value = csr->values[k];
     }
   }
 
-  if (!found) { printf("\nNot found"); }
+  return index;
+}
+
+/**
+ * Frees a hash index.
+ *
+ * @param index Pointer to hash index object to be freed, may be NULL.
+ */
+void freeHashIndex(HashIndex *index) {
+  if (!index) {
+    return;
+  }
+
+  free(index->slots);
+  free(index);
+}
+
+/**
+ * Finds an element through the hash index.
+ *
+ * @param index Pointer to hash index object.
+ * @param row, col Position of the element, may be out of range.
+ * @param[out] value Value of the element if it is a nonzero.
+ *
+ * @return True if the element is a nonzero, false if it is 0 or out of range.
+ */
+int lookupHash(HashIndex *index, int row, int col, int *value) {
+  if (row < 0 || col < 0) {
+    return 0;
+  }
 
+  uint64_t key = packPosition(row, col);
+  size_t slot = hashPosition(key) & index->mask;
+  while (index->slots[slot].key) {
+    if (index->slots[slot].key == key) {
+      *value = index->slots[slot].value;
+      return 1;
+    }
+    slot = (slot + 1) & index->mask;
+  }
   return 0;
 }
+
+/**
+ * Looks up many elements at once, spread over OpenMP threads when built with OpenMP.
+ * Zeros and positions out of range read as 0.
+ *
+ * @param csr Pointer to CSR matrix object.
+ * @param index Pointer to hash index of `csr` to use it instead of binary search, may be NULL.
+ * @param rows, cols Positions of the elements.
+ * @param count Number of positions.
+ * @param[out] values Values of the elements, `count` of them.
+ *
+ * @return Number of positions that hold a nonzero.
+ */
+size_t lookupBatch(CsrMatrix *csr, HashIndex *index, const int *rows, const int *cols, size_t count, int *values) {
+  size_t found = 0;
+
+  long long k;
+  OMP(parallel for reduction(+:found) schedule(static))
+  for (k = 0; k < (long long)count; ++k) {
+    int value;
+    int hit = index ? lookupHash(index, rows[k], cols[k], &value) : lookupCsr(csr, rows[k], cols[k], &value);
+    values[k] = hit ? value : 0;
+    found += hit;
+  }
+
+  return found;
+}
+
+/**
+ * Creates a CSR matrix with room for given number of nonzeros and every row start at 0.
+ *
+ * @param rows, cols Dimensions of the matrix.
+ * @param count Number of nonzeros to make room for.
+ *
+ * @return Pointer to newly created CsrMatrix object.
+ */
+CsrMatrix *createCsr(int rows, int cols, size_t count) {
+  CsrMatrix *csr = malloc(sizeof(*csr));
+  csr->rows = rows;
+  csr->cols = cols;
+  csr->rowStart = calloc((size_t)rows + 1, sizeof(*csr->rowStart));
+  csr->colIndex = malloc((count ? count : 1) * sizeof(*csr->colIndex));
+  csr->values = malloc((count ? count : 1) * sizeof(*csr->values));
+  if (!csr->rowStart || !csr->colIndex || !csr->values) {
+    fputs("Out of memory.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+
+  return csr;
+}
+
+/**
+ * Splits the rows into blocks of about the same nonzero count, so threads stay balanced even when
+ * a few rows hold most of the nonzeros. Block `block` covers rows `rowBlockStart(block)` up to
+ * (excluding) `rowBlockStart(block + 1)`.
+ *
+ * @param csr Pointer to CSR matrix object.
+ * @param block Index of the block, from 0 to `blocks`.
+ * @param blocks Number of blocks.
+ *
+ * @return First row of the block, `csr->rows` for block `blocks`.
+ */
+int rowBlockStart(CsrMatrix *csr, int block, int blocks) {
+  if (block >= blocks) {
+    return csr->rows;
+  }
+
+  /* First row that starts at or after the block's share of nonzeros. */
+  size_t target = (size_t)((double)csr->rowStart[csr->rows] * block / blocks);
+  int low = 0;
+  int high = csr->rows;
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    if (csr->rowStart[mid] < target) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+/**
+ * Multiplies a sparse matrix with a vector, `y = A x`. Rows are split into blocks of equal
+ * nonzero count, one per OpenMP thread.
+ *
+ * @param csr Pointer to CSR matrix object `A`.
+ * @param x Vector of `csr->cols` values.
+ * @param[out] y Vector of `csr->rows` values.
+ */
+void spmv(CsrMatrix *csr, const double *x, double *y) {
+  OMP(parallel)
+  {
+#ifdef _OPENMP
+    int blocks = omp_get_num_threads();
+    int block = omp_get_thread_num();
+#else
+    int blocks = 1;
+    int block = 0;
+#endif
+    int end = rowBlockStart(csr, block + 1, blocks);
+
+    int row = rowBlockStart(csr, block, blocks);
+    for (; row < end; ++row) {
+      double sum = 0.0;
+      size_t k;
+      OMP(simd reduction(+:sum))
+      for (k = csr->rowStart[row]; k < csr->rowStart[row + 1]; ++k) {
+        sum += csr->values[k] * x[csr->colIndex[k]];
+      }
+      y[row] = sum;
+    }
+  }
+}
+
+/**
+ * Multiplies a sparse matrix with a dense matrix of `width` columns, `Y = A X`. Dense matrices are
+ * stored row by row, so every nonzero of `A` scales one contiguous row of `X`.
+ *
+ * @param csr Pointer to CSR matrix object `A`.
+ * @param x Dense `csr->cols` x `width` matrix.
+ * @param width Number of columns of `x` and `y`.
+ * @param[out] y Dense `csr->rows` x `width` matrix.
+ */
+void spmm(CsrMatrix *csr, const double *x, size_t width, double *y) {
+  OMP(parallel)
+  {
+#ifdef _OPENMP
+    int blocks = omp_get_num_threads();
+    int block = omp_get_thread_num();
+#else
+    int blocks = 1;
+    int block = 0;
+#endif
+    int end = rowBlockStart(csr, block + 1, blocks);
+
+    int row = rowBlockStart(csr, block, blocks);
+    for (; row < end; ++row) {
+      double *out = y + (size_t)row * width;
+      size_t j = 0;
+      for (; j < width; ++j) {
+        out[j] = 0.0;
+      }
+
+      size_t k = csr->rowStart[row];
+      for (; k < csr->rowStart[row + 1]; ++k) {
+        const double *in = x + (size_t)csr->colIndex[k] * width;
+        double value = csr->values[k];
+        OMP(simd)
+        for (j = 0; j < width; ++j) {
+          out[j] += value * in[j];
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Transposes a sparse matrix with a counting sort on column indices. Rows are scattered in order,
+ * so the columns of the result come out sorted without another sort.
+ *
+ * @param csr Pointer to CSR matrix object to be transposed.
+ *
+ * @return Pointer to newly created CsrMatrix object of the transpose.
+ */
+CsrMatrix *transposeCsr(CsrMatrix *csr) {
+  size_t count = csr->rowStart[csr->rows];
+  CsrMatrix *result = createCsr(csr->cols, csr->rows, count);
+
+  size_t k = 0;
+  for (; k < count; ++k) {
+    ++result->rowStart[csr->colIndex[k] + 1];
+  }
+  int col = 0;
+  for (; col < csr->cols; ++col) {
+    result->rowStart[col + 1] += result->rowStart[col];
+  }
+
+  /* `rowStart[col]` is used as the write position of each column and ends up one column ahead. */
+  int row = 0;
+  for (; row < csr->rows; ++row) {
+    for (k = csr->rowStart[row]; k < csr->rowStart[row + 1]; ++k) {
+      size_t at = result->rowStart[csr->colIndex[k]]++;
+      result->colIndex[at] = row;
+      result->values[at] = csr->values[k];
+    }
+  }
+  for (col = csr->cols; col > 0; --col) {
+    result->rowStart[col] = result->rowStart[col - 1];
+  }
+  result->rowStart[0] = 0;
+
+  return result;
+}
+
+/**
+ * Adds two sparse matrices of the same dimensions. Every row is merged twice, once to count the
+ * nonzeros of the sum and once to write them, so the result is allocated exactly. Elements that
+ * cancel out to 0 are not stored, values wrap like `int` arithmetic.
+ *
+ * @param a, b Pointers to CSR matrix objects to be added.
+ *
+ * @return Pointer to newly created CsrMatrix object of `a + b`.
+ */
+CsrMatrix *addCsr(CsrMatrix *a, CsrMatrix *b) {
+  if (a->rows != b->rows || a->cols != b->cols) {
+    fputs("Cannot add matrices of different dimensions.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+
+  size_t *counts = calloc((size_t)a->rows + 1, sizeof(*counts));
+  long long row;
+  int pass = 0;
+  CsrMatrix *result = NULL;
+  for (; pass < 2; ++pass) {
+    OMP(parallel for schedule(dynamic, 256))
+    for (row = 0; row < a->rows; ++row) {
+      size_t i = a->rowStart[row];
+      size_t j = b->rowStart[row];
+      size_t at = pass ? result->rowStart[row] : 0;
+      while (i < a->rowStart[row + 1] || j < b->rowStart[row + 1]) {
+        int col;
+        int value;
+        if (j == b->rowStart[row + 1] || (i < a->rowStart[row + 1] && a->colIndex[i] < b->colIndex[j])) {
+          col = a->colIndex[i];
+          value = a->values[i++];
+        } else if (i == a->rowStart[row + 1] || b->colIndex[j] < a->colIndex[i]) {
+          col = b->colIndex[j];
+          value = b->values[j++];
+        } else {
+          col = a->colIndex[i];
+          value = (int)((unsigned)a->values[i++] + (unsigned)b->values[j++]);
+        }
+
+        if (value != 0) {
+          if (pass) {
+            result->colIndex[at] = col;
+            result->values[at] = value;
+          }
+          ++at;
+        }
+      }
+      if (!pass) {
+        counts[row + 1] = at;
+      }
+    }
+
+    if (!pass) {
+      for (row = 0; row < a->rows; ++row) {
+        counts[row + 1] += counts[row];
+      }
+      result = createCsr(a->rows, a->cols, counts[a->rows]);
+      memcpy(result->rowStart, counts, ((size_t)a->rows + 1) * sizeof(*counts));
+    }
+  }
+
+  free(counts);
+  return result;
+}
+
+/**
+ * Multiplies two sparse matrices row by row (Gustavson's method). Each thread adds the scaled rows
+ * of `b` into a dense accumulator and remembers which columns it touched. The first pass only
+ * counts those columns, so the result is allocated exactly before the second pass writes it.
+ * Elements that cancel out to 0 are not stored, values wrap like `int` arithmetic.
+ *
+ * @param a, b Pointers to CSR matrix objects, `a->cols` must equal `b->rows`.
+ *
+ * @return Pointer to newly created CsrMatrix object of `a * b`.
+ */
+CsrMatrix *multiplyCsr(CsrMatrix *a, CsrMatrix *b) {
+  if (a->cols != b->rows) {
+    fputs("Cannot multiply matrices of mismatched dimensions.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+
+  size_t *counts = calloc((size_t)a->rows + 1, sizeof(*counts));
+  CsrMatrix *result = NULL;
+  int pass = 0;
+  for (; pass < 2; ++pass) {
+    OMP(parallel)
+    {
+      size_t width = b->cols ? (size_t)b->cols : 1;
+      int *sums = calloc(width, sizeof(*sums));
+      char *touched = calloc(width, sizeof(*touched));
+      int *cols = malloc(width * sizeof(*cols));
+
+      long long row;
+      OMP(for schedule(dynamic, 64))
+      for (row = 0; row < a->rows; ++row) {
+        size_t used = 0;
+        size_t i = a->rowStart[row];
+        for (; i < a->rowStart[row + 1]; ++i) {
+          int scale = a->values[i];
+          int inner = a->colIndex[i];
+          size_t j = b->rowStart[inner];
+          for (; j < b->rowStart[inner + 1]; ++j) {
+            int col = b->colIndex[j];
+            if (!touched[col]) {
+              touched[col] = 1;
+              cols[used++] = col;
+            }
+            sums[col] = (int)((unsigned)sums[col] + (unsigned)scale * (unsigned)b->values[j]);
+          }
+        }
+
+        if (pass) {
+          qsort(cols, used, sizeof(*cols), compareInts);
+        }
+        size_t at = pass ? result->rowStart[row] : 0;
+        size_t k = 0;
+        for (; k < used; ++k) {
+          int col = cols[k];
+          if (sums[col] != 0) {
+            if (pass) {
+              result->colIndex[at] = col;
+              result->values[at] = sums[col];
+            }
+            ++at;
+          }
+          sums[col] = 0;
+          touched[col] = 0;
+        }
+        if (!pass) {
+          counts[row + 1] = at;
+        }
+      }
+
+      free(sums);
+      free(touched);
+      free(cols);
+    }
+
+    if (!pass) {
+      int row = 0;
+      for (; row < a->rows; ++row) {
+        counts[row + 1] += counts[row];
+      }
+      result = createCsr(a->rows, b->cols, counts[a->rows]);
+      memcpy(result->rowStart, counts, ((size_t)a->rows + 1) * sizeof(*counts));
+    }
+  }
+
+  free(counts);
+  return result;
+}
+
+/**
+ * Orders integers ascending, for `qsort`.
+ *
+ * @param a, b Pointers to the integers to be compared.
+ *
+ * @return Negative, zero or positive as `a` comes before, with or after `b`.
+ */
+int compareInts(const void *a, const void *b) {
+  int x = *(const int *)a;
+  int y = *(const int *)b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * Orders hash slots by key, for sorting packed positions with `qsort`.
+ *
+ * @param a, b Pointers to the slots to be compared.
+ *
+ * @return Negative, zero or positive as `a` comes before, with or after `b`.
+ */
+int compareSlots(const void *a, const void *b) {
+  uint64_t x = ((const HashSlot *)a)->key;
+  uint64_t y = ((const HashSlot *)b)->key;
+  return (x > y) - (x < y);
+}
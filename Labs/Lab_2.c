@@ -1,6 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <math.h>
+#include <stdint.h>
 /*
  * Disaridan verilen 2 adet N basamakli sayi ayri ayri linkli listelerde saklanmaktadir.
  * Sayilari toplayip sonucu tek bir degiskende saklayip ekrana yazdiran programin C kodu asagida eksik verilmistir.
@@ -20,13 +20,83 @@
  * Sonuc: 5557
  */
 
+/* Numbers are kept in limbs of 9 decimal digits, so a limb sum with carry always fits in 32 bits. */
+#define LIMB_BASE 1000000000u
+#define LIMB_DIGITS 9
+
+/* Operands with fewer limbs than this are multiplied schoolbook, Karatsuba recursion stops here. */
+#define KARATSUBA_THRESHOLD 24
+
+/* Nodes are carved out of slabs of this many nodes, 64 KiB each on 64-bit targets. */
+#define NODE_SLAB_SIZE 4096
+
 typedef struct Node {
     int data;
     struct Node* next;
 } Node;
 
+/* Block of nodes handed out one by one, never freed on its own. */
+typedef struct NodeSlab {
+  struct NodeSlab *next;
+  Node nodes[NODE_SLAB_SIZE];
+} NodeSlab;
+
+/*
+ * Allocator behind `createNode` and `freeList`. Nodes come from the free list first, then from the
+ * newest slab. Freed lists are spliced onto the free list, and `releaseNodes` returns every slab
+ * at once.
+ */
+typedef struct {
+  NodeSlab *slabs;
+  size_t used;
+  Node *freeNodes;
+} NodePool;
+
+static NodePool nodePool = {NULL, NODE_SLAB_SIZE, NULL};
+
+/*
+ * Non-negative number of any length, `limbs[0]` holds the lowest 9 digits. `length` is at least 1
+ * and the highest limb is not 0 unless the number is 0.
+ */
+typedef struct {
+  size_t length;
+  uint32_t *limbs;
+} BigNumber;
+
+void releaseNodes(void);
+BigNumber *createBigNumber(size_t);
+void trimBigNumber(BigNumber *);
+void freeBigNumber(BigNumber *);
+BigNumber *fromList(Node *);
+Node *toList(BigNumber *);
+BigNumber *addBigNumbers(BigNumber *, BigNumber *);
+int compareBigNumbers(BigNumber *, BigNumber *);
+BigNumber *subtractBigNumbers(BigNumber *, BigNumber *);
+BigNumber *multiplyBigNumbers(BigNumber *, BigNumber *);
+void printBigNumber(FILE *, BigNumber *);
+uint32_t addLimbs(uint32_t *, const uint32_t *, size_t, const uint32_t *, size_t);
+void subtractLimbs(uint32_t *, const uint32_t *, size_t, const uint32_t *, size_t);
+void multiplySchoolbook(uint32_t *, const uint32_t *, size_t, const uint32_t *, size_t);
+size_t karatsubaScratch(size_t);
+void multiplyKaratsuba(uint32_t *, const uint32_t *, const uint32_t *, size_t, uint32_t *);
+
 Node* createNode(int data) {
-  Node *node = malloc(sizeof(*node));
+  Node *node = nodePool.freeNodes;
+  if (node) {
+    nodePool.freeNodes = node->next;
+  } else {
+    if (nodePool.used == NODE_SLAB_SIZE) {
+      NodeSlab *slab = malloc(sizeof(*slab));
+      if (!slab) {
+        fputs("Out of memory.\n", stderr);
+        exit(EXIT_FAILURE);
+      }
+      slab->next = nodePool.slabs;
+      nodePool.slabs = slab;
+      nodePool.used = 0;
+    }
+    node = &nodePool.slabs->nodes[nodePool.used++];
+  }
   node->next = NULL;
   node->data = data;
 
@@ -34,12 +104,30 @@ Node* createNode(int data) {
 }
 
 void freeList(Node* head) {
-    Node* temp;
-    while (head != NULL) {
-        temp = head;
-        head = head->next;
-        free(temp);
-    }
+  if (!head) {
+    return;
+  }
+
+  /* The whole list goes onto the free list in one splice. */
+  Node *tail = head;
+  while (tail->next) {
+    tail = tail->next;
+  }
+  tail->next = nodePool.freeNodes;
+  nodePool.freeNodes = head;
+}
+
+/**
+ * Frees every node slab. All lists are invalid afterwards.
+ */
+void releaseNodes(void) {
+  while (nodePool.slabs) {
+    NodeSlab *next = nodePool.slabs->next;
+    free(nodePool.slabs);
+    nodePool.slabs = next;
+  }
+  nodePool.used = NODE_SLAB_SIZE;
+  nodePool.freeNodes = NULL;
 }
 
 void push(Node** headRef, int data) {
@@ -52,31 +140,459 @@ void push(Node** headRef, int data) {
     }
 }
 
-int addLinkedLists(Node* l1, Node* l2) {
-    int carry = 0;
-    Node *ptr_l1 = l1;
-    Node *ptr_l2 = l2;
+/**
+ * Adds the numbers in two digit lists, lowest digit first. Lists may have any and different lengths.
+ *
+ * @param l1, l2 Heads of the digit lists.
+ *
+ * @return Pointer to newly created BigNumber object of the sum.
+ */
+BigNumber *addLinkedLists(Node* l1, Node* l2) {
+  BigNumber *a = fromList(l1);
+  BigNumber *b = fromList(l2);
+  BigNumber *sum = addBigNumbers(a, b);
+
+  freeBigNumber(a);
+  freeBigNumber(b);
+  return sum;
+}
+
+/**
+ * Creates a number with room for given number of limbs, all 0.
+ *
+ * @param length Number of limbs, at least 1 is allocated.
+ *
+ * @return Pointer to newly created BigNumber object.
+ */
+BigNumber *createBigNumber(size_t length) {
+  BigNumber *number = malloc(sizeof(*number));
+  number->length = length ? length : 1;
+  number->limbs = calloc(number->length, sizeof(*number->limbs));
+  if (!number->limbs) {
+    fputs("Out of memory.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+
+  return number;
+}
+
+/**
+ * Drops the zero limbs on top of a number, keeping at least one limb.
+ *
+ * @param number Pointer to number object.
+ */
+void trimBigNumber(BigNumber *number) {
+  while (number->length > 1 && number->limbs[number->length - 1] == 0) {
+    --number->length;
+  }
+}
 
-    int sum = 0;
-    int digit = 0;
+/**
+ * Frees a number and its limbs.
+ *
+ * @param number Pointer to number object to be freed.
+ */
+void freeBigNumber(BigNumber *number) {
+  if (!number) {
+    return;
+  }
 
-    while (ptr_l1 && ptr_l2) {
-      int digit_total = (ptr_l1->data + ptr_l2->data + carry);
+  free(number->limbs);
+  free(number);
+}
 
-      sum += digit_total % 10 * pow(10, digit++);
+/**
+ * Packs a digit list, lowest digit first, into limbs of 9 digits.
+ *
+ * @param head Head of the digit list, NULL stands for 0.
+ *
+ * @return Pointer to newly created BigNumber object.
+ */
+BigNumber *fromList(Node *head) {
+  static const uint32_t scale[LIMB_DIGITS] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
 
-      carry = (digit_total > 9) ? 1 : 0;
+  /* One pass over the list: digits are gathered in a register and limbs grow by doubling. */
+  size_t capacity = 16;
+  size_t length = 0;
+  uint32_t *limbs = malloc(capacity * sizeof(*limbs));
+  uint32_t limb = 0;
+  int position = 0;
 
-      ptr_l1 = ptr_l1->next;
-      ptr_l2 = ptr_l2->next;
+  Node *temp = head;
+  for (; temp; temp = temp->next) {
+    if (temp->data < 0 || temp->data > 9) {
+      fprintf(stderr, "Invalid digit %d.\n", temp->data);
+      exit(EXIT_FAILURE);
     }
-    if (carry) {
-      sum += carry * pow(10, digit++);
+    limb += (uint32_t)temp->data * scale[position];
+    if (++position == LIMB_DIGITS) {
+      if (length == capacity) {
+        capacity *= 2;
+        limbs = realloc(limbs, capacity * sizeof(*limbs));
+      }
+      limbs[length++] = limb;
+      limb = 0;
+      position = 0;
+    }
+  }
+  if (position || !length) {
+    if (length == capacity) {
+      limbs = realloc(limbs, (capacity + 1) * sizeof(*limbs));
+    }
+    limbs[length++] = limb;
+  }
+
+  BigNumber *number = malloc(sizeof(*number));
+  number->length = length;
+  number->limbs = limbs;
+  trimBigNumber(number);
+  return number;
+}
+
+/**
+ * Unpacks a number into a digit list, lowest digit first, without leading zeros.
+ *
+ * @param number Pointer to number object.
+ *
+ * @return Head of the new digit list, free with `freeList`.
+ */
+Node *toList(BigNumber *number) {
+  Node *head = NULL;
+  size_t i = number->length;
+  int leading = 1;
+  while (i-- > 0) {
+    uint32_t limb = number->limbs[i];
+    uint32_t scale = LIMB_BASE / 10;
+    for (; scale; scale /= 10) {
+      int digit = (int)(limb / scale % 10);
+      if (leading && digit == 0 && (i || scale > 1)) {
+        continue;
+      }
+      leading = 0;
+      push(&head, digit);
     }
+  }
+  return head;
+}
+
+/**
+ * Subtracts the numbers in two digit lists, lowest digit first. The first number must not be smaller.
+ *
+ * @param l1, l2 Heads of the digit lists.
+ *
+ * @return Pointer to newly created BigNumber object of the difference.
+ */
+BigNumber *subtractLinkedLists(Node* l1, Node* l2) {
+  BigNumber *a = fromList(l1);
+  BigNumber *b = fromList(l2);
+  BigNumber *difference = subtractBigNumbers(a, b);
+
+  freeBigNumber(a);
+  freeBigNumber(b);
+  return difference;
+}
+
+/**
+ * Multiplies the numbers in two digit lists, lowest digit first.
+ *
+ * @param l1, l2 Heads of the digit lists.
+ *
+ * @return Pointer to newly created BigNumber object of the product.
+ */
+BigNumber *multiplyLinkedLists(Node* l1, Node* l2) {
+  BigNumber *a = fromList(l1);
+  BigNumber *b = fromList(l2);
+  BigNumber *product = multiplyBigNumbers(a, b);
+
+  freeBigNumber(a);
+  freeBigNumber(b);
+  return product;
+}
 
+/**
+ * Adds two numbers of any length.
+ *
+ * @param a, b Pointers to the numbers to be added.
+ *
+ * @return Pointer to newly created BigNumber object of `a + b`.
+ */
+BigNumber *addBigNumbers(BigNumber *a, BigNumber *b) {
+  if (a->length < b->length) {
+    BigNumber *temp = a;
+    a = b;
+    b = temp;
+  }
+
+  BigNumber *sum = createBigNumber(a->length + 1);
+  sum->limbs[a->length] = addLimbs(sum->limbs, a->limbs, a->length, b->limbs, b->length);
+
+  trimBigNumber(sum);
   return sum;
 }
 
+/**
+ * Compares two numbers.
+ *
+ * @param a, b Pointers to the numbers to be compared.
+ *
+ * @return Negative, 0 or positive when `a` is less than, equal to or greater than `b`.
+ */
+int compareBigNumbers(BigNumber *a, BigNumber *b) {
+  if (a->length != b->length) {
+    return a->length < b->length ? -1 : 1;
+  }
+
+  size_t i = a->length;
+  while (i-- > 0) {
+    if (a->limbs[i] != b->limbs[i]) {
+      return a->limbs[i] < b->limbs[i] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Subtracts two numbers. Numbers are non-negative, so `a` must not be less than `b`.
+ *
+ * @param a, b Pointers to the numbers.
+ *
+ * @return Pointer to newly created BigNumber object of `a - b`.
+ */
+BigNumber *subtractBigNumbers(BigNumber *a, BigNumber *b) {
+  if (compareBigNumbers(a, b) < 0) {
+    fputs("Subtraction result would be negative.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+
+  BigNumber *difference = createBigNumber(a->length);
+  subtractLimbs(difference->limbs, a->limbs, a->length, b->limbs, b->length);
+
+  trimBigNumber(difference);
+  return difference;
+}
+
+/**
+ * Multiplies two numbers. Short operands go schoolbook. Otherwise the longer operand is cut into
+ * pieces as long as the shorter one, each piece is multiplied with Karatsuba and the partial
+ * products are added in place.
+ *
+ * @param a, b Pointers to the numbers to be multiplied.
+ *
+ * @return Pointer to newly created BigNumber object of `a * b`.
+ */
+BigNumber *multiplyBigNumbers(BigNumber *a, BigNumber *b) {
+  if (a->length < b->length) {
+    BigNumber *temp = a;
+    a = b;
+    b = temp;
+  }
+
+  BigNumber *product = createBigNumber(a->length + b->length);
+  size_t n = b->length;
+  if (n < KARATSUBA_THRESHOLD) {
+    multiplySchoolbook(product->limbs, a->limbs, a->length, b->limbs, n);
+    trimBigNumber(product);
+    return product;
+  }
+
+  uint32_t *scratch = malloc(karatsubaScratch(n) * sizeof(*scratch));
+  uint32_t *piece = malloc(n * sizeof(*piece));
+  uint32_t *partial = malloc(2 * n * sizeof(*partial));
+  if (!scratch || !piece || !partial) {
+    fputs("Out of memory.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+
+  size_t offset = 0;
+  for (; offset < a->length; offset += n) {
+    size_t count = a->length - offset < n ? a->length - offset : n;
+    const uint32_t *source = a->limbs + offset;
+    if (count < n) {
+      /* The last piece is padded with zeros, Karatsuba wants equal lengths. */
+      size_t i = 0;
+      for (; i < count; ++i) {
+        piece[i] = source[i];
+      }
+      for (; i < n; ++i) {
+        piece[i] = 0;
+      }
+      source = piece;
+    }
+    multiplyKaratsuba(partial, source, b->limbs, n, scratch);
+
+    /* The partial product fits in the room left in `product` once its zero top is dropped. */
+    size_t room = product->length - offset;
+    size_t used = 2 * n < room ? 2 * n : room;
+    addLimbs(product->limbs + offset, product->limbs + offset, room, partial, used);
+  }
+
+  free(scratch);
+  free(piece);
+  free(partial);
+  trimBigNumber(product);
+  return product;
+}
+
+/**
+ * Prints a number in decimal, without leading zeros.
+ *
+ * @param fp File to print to.
+ * @param number Pointer to number object.
+ */
+void printBigNumber(FILE *fp, BigNumber *number) {
+  size_t i = number->length - 1;
+  fprintf(fp, "%u", (unsigned)number->limbs[i]);
+  while (i-- > 0) {
+    fprintf(fp, "%09u", (unsigned)number->limbs[i]);
+  }
+}
+
+/**
+ * Adds two limb arrays, `an >= bn`. The carry loop is branch free: a limb sum is below 2 * 10^9,
+ * so one compare gives the carry. `r` may be the same array as `a`.
+ *
+ * @param r Array of `an` limbs for the sum.
+ * @param a, an Longer operand and its limb count.
+ * @param b, bn Shorter operand and its limb count.
+ *
+ * @return Carry out of the top limb, 0 or 1.
+ */
+uint32_t addLimbs(uint32_t *r, const uint32_t *a, size_t an, const uint32_t *b, size_t bn) {
+  uint32_t carry = 0;
+  size_t i = 0;
+  for (; i < bn; ++i) {
+    uint32_t limb = a[i] + b[i] + carry;
+    carry = limb >= LIMB_BASE;
+    r[i] = limb - (carry ? LIMB_BASE : 0);
+  }
+  for (; i < an && carry; ++i) {
+    uint32_t limb = a[i] + carry;
+    carry = limb >= LIMB_BASE;
+    r[i] = limb - (carry ? LIMB_BASE : 0);
+  }
+  if (r != a) {
+    for (; i < an; ++i) {
+      r[i] = a[i];
+    }
+  }
+  return carry;
+}
+
+/**
+ * Subtracts two limb arrays, `a >= b` as numbers. Borrow is handled like the carry in `addLimbs`,
+ * a limb difference that wraps around is above the base. `r` may be the same array as `a`.
+ *
+ * @param r Array of `an` limbs for the difference.
+ * @param a, an Minuend and its limb count.
+ * @param b, bn Subtrahend and its limb count, `bn <= an`.
+ */
+void subtractLimbs(uint32_t *r, const uint32_t *a, size_t an, const uint32_t *b, size_t bn) {
+  uint32_t borrow = 0;
+  size_t i = 0;
+  for (; i < bn; ++i) {
+    uint32_t limb = a[i] - b[i] - borrow;
+    borrow = limb >= LIMB_BASE;
+    r[i] = limb + (borrow ? LIMB_BASE : 0);
+  }
+  for (; i < an && borrow; ++i) {
+    uint32_t limb = a[i] - borrow;
+    borrow = limb >= LIMB_BASE;
+    r[i] = limb + (borrow ? LIMB_BASE : 0);
+  }
+  if (r != a) {
+    for (; i < an; ++i) {
+      r[i] = a[i];
+    }
+  }
+}
+
+/**
+ * Schoolbook multiplication of two limb arrays. A limb product plus a limb and a carry stays
+ * below 10^18 + 2 * 10^9, well inside 64 bits.
+ *
+ * @param r Array of `an + bn` limbs for the product, must not overlap the operands.
+ * @param a, an First operand and its limb count.
+ * @param b, bn Second operand and its limb count.
+ */
+void multiplySchoolbook(uint32_t *r, const uint32_t *a, size_t an, const uint32_t *b, size_t bn) {
+  size_t i = 0;
+  for (; i < an + bn; ++i) {
+    r[i] = 0;
+  }
+
+  for (i = 0; i < bn; ++i) {
+    uint64_t factor = b[i];
+    uint64_t carry = 0;
+    if (!factor) {
+      continue;
+    }
+
+    size_t j = 0;
+    for (; j < an; ++j) {
+      uint64_t t = r[i + j] + factor * a[j] + carry;
+      carry = t / LIMB_BASE;
+      r[i + j] = (uint32_t)(t - carry * LIMB_BASE);
+    }
+    r[i + an] = (uint32_t)carry;
+  }
+}
+
+/**
+ * Size of the scratch array `multiplyKaratsuba` needs for operands of `n` limbs.
+ *
+ * @param n Operand limb count.
+ *
+ * @return Number of limbs.
+ */
+size_t karatsubaScratch(size_t n) {
+  size_t size = 0;
+  while (n >= KARATSUBA_THRESHOLD) {
+    size_t high = n - n / 2;
+    size += 4 * (high + 1);
+    n = high + 1;
+  }
+  return size;
+}
+
+/**
+ * Karatsuba multiplication of two limb arrays of equal length. With `a = a1 * B^m + a0`, and
+ * likewise for `b`, the product is `z2 * B^2m + z1 * B^m + z0` where `z0 = a0 * b0`,
+ * `z2 = a1 * b1` and `z1 = (a0 + a1) * (b0 + b1) - z0 - z2`: three half size products instead of
+ * four.
+ *
+ * @param r Array of `2 * n` limbs for the product, must not overlap the operands.
+ * @param a, b Operands, `n` limbs each.
+ * @param n Operand limb count.
+ * @param scratch Array of `karatsubaScratch(n)` limbs.
+ */
+void multiplyKaratsuba(uint32_t *r, const uint32_t *a, const uint32_t *b, size_t n, uint32_t *scratch) {
+  if (n < KARATSUBA_THRESHOLD) {
+    multiplySchoolbook(r, a, n, b, n);
+    return;
+  }
+
+  size_t low = n / 2;
+  size_t high = n - low;
+  uint32_t *sumA = scratch;
+  uint32_t *sumB = sumA + high + 1;
+  uint32_t *middle = sumB + high + 1;
+  uint32_t *rest = middle + 2 * (high + 1);
+
+  /* z0 and z2 go straight to their places in `r`, they do not overlap. */
+  multiplyKaratsuba(r, a, b, low, rest);
+  multiplyKaratsuba(r + 2 * low, a + low, b + low, high, rest);
+
+  sumA[high] = addLimbs(sumA, a + low, high, a, low);
+  sumB[high] = addLimbs(sumB, b + low, high, b, low);
+  multiplyKaratsuba(middle, sumA, sumB, high + 1, rest);
+  subtractLimbs(middle, middle, 2 * (high + 1), r, 2 * low);
+  subtractLimbs(middle, middle, 2 * (high + 1), r + 2 * low, 2 * high);
+
+  /* z1 is below B^(2 * high + 1), so its top limb is 0 and the rest fits above `low`. */
+  addLimbs(r + low, r + low, 2 * n - low, middle, 2 * high + 1);
+}
+
+#ifndef BENCHMARK
 /*
  * Test
  */
@@ -96,11 +612,16 @@ int main() {
         push(&number1, digits1[i]);
         push(&number2, digits2[i]);
     }
-    int toplam = addLinkedLists(number1, number2);
-    printf("Sonuc: %d\n", toplam);
+    BigNumber *toplam = addLinkedLists(number1, number2);
+    fputs("Sonuc: ", stdout);
+    printBigNumber(stdout, toplam);
+    fputc('\n', stdout);
 
+    freeBigNumber(toplam);
     freeList(number1);
     freeList(number2);
+    releaseNodes();
 
     return 0;
 }
+#endif
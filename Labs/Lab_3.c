@@ -1,5 +1,20 @@
+/* Asks for `fseeko` with 64-bit offsets, see `seekSpill`. */
+#ifndef _WIN32
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#define _FILE_OFFSET_BITS 64
+#endif
 #include<stdio.h>
 #include<stdlib.h>
+#include<string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#include <stdatomic.h>
+#ifndef _WIN32
+#include <sched.h>
+#endif
+#endif
 
 /*
  * Write the code of the program that performs the operations mentioned and prints the TOTAL value in the related STACK to the screen in order, step by step, in C language.
@@ -15,19 +30,92 @@
  * Output: 5 4 9 1 2 
  */
 
+/*
+ * Ring buffer. `size` is a power of two, `queueEnd` and `currItem` count every enqueue and dequeue
+ * and are only masked when indexing, so `queueEnd - currItem` is the item count even after they
+ * wrap around.
+ */
 typedef struct QUEUE{
 	int *arr;
-	int size;
-	int queueEnd;
-	int currItem;
+	unsigned size;
+	unsigned queueEnd;
+	unsigned currItem;
 } queue;
 
+#ifdef _OPENMP
+/* Producer and consumer fields of the lock-free queue sit on separate lines of this size. */
+#define CACHE_LINE 64
+/* The lock-free queue publishes its indices once every this many items, must be a power of two. */
+#define SPSC_BATCH 64
+/* Empty or full waits spin this many times before giving the CPU away. */
+#define SPIN_LIMIT 128
+
+/*
+ * Lock-free ring buffer for one producer and one consumer thread. `tail` and `head` are the only
+ * shared indices. Each side works on its own copy (`pending`, `taken`), publishes it with a
+ * release store every `SPSC_BATCH` items or before it waits, and keeps a cached copy of the
+ * other side's index so it reads the other cache line only when the queue looks full or empty.
+ */
+typedef struct SPSC_QUEUE{
+	int *arr;
+	unsigned size;
+	_Alignas(CACHE_LINE) atomic_uint tail;
+	unsigned pending;
+	unsigned headCache;
+	_Alignas(CACHE_LINE) atomic_uint head;
+	unsigned taken;
+	unsigned tailCache;
+} spscQueue;
+#endif
+
 typedef struct STACK{
 	int *arr;
 	int size;
 	int currP;
 } stack;
 
+/* Digits of the streaming adder go through in chunks of this many. */
+#define CHUNK_DIGITS 65536
+/* Default bytes of digits the streaming adder keeps in memory, half for each spill buffer. */
+#define MEMORY_BUDGET (64 << 20)
+/* Input is read in blocks of this many bytes. */
+#define READ_BLOCK_SIZE 65536
+
+/* Spill files may grow past 2 GiB, where the `long` offset of `fseek` wraps on Windows. */
+#ifdef _WIN32
+#define seekSpill(file, offset) _fseeki64(file, (__int64)(offset), SEEK_SET)
+#else
+#define seekSpill(file, offset) fseeko(file, (off_t)(offset), SEEK_SET)
+#endif
+
+/*
+ * Digit store that keeps the newest digits in memory and moves older ones to a temporary file
+ * once the memory part is full. Digits are read back from the start like a queue with
+ * `spillRead`, or from the end like a stack with `spillPop`.
+ */
+typedef struct SPILL{
+	unsigned char *arr;
+	size_t size;
+	size_t count;
+	FILE *file;
+	size_t spilled;
+	size_t readPos;
+} spill;
+
+/* Buffered reader of whitespace separated input. */
+typedef struct {
+	FILE *fp;
+	char *block;
+	size_t length;
+	size_t pos;
+} digitReader;
+
+/* Read-only view of consecutive items, valid until the next change to the stack or queue. */
+typedef struct {
+	const int *data;
+	size_t length;
+} span;
+
 
 stack* createStack(int size) {
 	stack* newStack=(stack*)malloc(sizeof(stack));
@@ -52,7 +140,7 @@ void push(stack* Stack,int newItem) {
 
 int pop(stack* Stack) {
 	if(Stack->currP<=0)
-		return NULL;
+		return 0;
 	return Stack->arr[--Stack->currP];
 }
 
@@ -69,39 +157,58 @@ void printStack(stack* Stack) {
 
 
 queue* createQueue(int size) {
+	unsigned capacity=1;
+	while(capacity<(unsigned)size)
+		capacity*=2;
 	queue* newQueue=(queue*)malloc(sizeof(queue));
-	newQueue->arr=(int*)malloc(size*sizeof(int));
-	newQueue->size=size;
+	newQueue->arr=(int*)malloc(capacity*sizeof(int));
+	newQueue->size=capacity;
 	newQueue->queueEnd=0;
 	newQueue->currItem=0;
 	return newQueue;
 }
 
+/*
+ * Doubles a full queue. Items are copied to the start of the new array in queue order, so the
+ * part that wrapped around to the front of the old array lands behind the rest.
+ */
 void reSizeQueue(queue *Queue) {
-	printf("Resizing Queue from %d to %d\n",Queue->size,Queue->size*2);
+	unsigned count=Queue->queueEnd-Queue->currItem;
+	unsigned head=Queue->currItem&(Queue->size-1);
+	unsigned first=Queue->size-head<count ? Queue->size-head : count;
+	int *arr=(int*)malloc(Queue->size*2*sizeof(int));
+	if(!arr) {
+		fputs("Out of memory.\n", stderr);
+		exit(EXIT_FAILURE);
+	}
+	memcpy(arr,Queue->arr+head,first*sizeof(int));
+	memcpy(arr+first,Queue->arr,(count-first)*sizeof(int));
+	free(Queue->arr);
+	Queue->arr=arr;
 	Queue->size*=2;
-	Queue->arr=realloc(Queue->arr,Queue->size*sizeof(int));
+	Queue->currItem=0;
+	Queue->queueEnd=count;
 }
 
 
 void enq(queue* Queue,int newItem) {
-	Queue->arr[Queue->queueEnd++]=newItem;
-	if(Queue->queueEnd==Queue->size)
+	if(Queue->queueEnd-Queue->currItem==Queue->size)
 		reSizeQueue(Queue);
+	Queue->arr[Queue->queueEnd++&(Queue->size-1)]=newItem;
 }
 
 int deq(queue* Queue) {
-	if((Queue->currItem>=Queue->queueEnd)||(Queue->queueEnd==0))
-		return NULL;
-	return Queue->arr[Queue->currItem++];
+	if(Queue->currItem==Queue->queueEnd)
+		return 0;
+	return Queue->arr[Queue->currItem++&(Queue->size-1)];
 }
 
 
 void printQueue(queue* Queue) {
-	int i;
+	unsigned i;
 	printf("Current Queue: ");
-	for(i=Queue->currItem;i<Queue->queueEnd;i++)
-		printf("%d ",Queue->arr[i]);
+	for(i=Queue->currItem;i!=Queue->queueEnd;i++)
+		printf("%d ",Queue->arr[i&(Queue->size-1)]);
 
 	printf("\n");
 
@@ -118,7 +225,655 @@ void freeStack(stack* Stack) {
 }
 
 
-int main() {
+/**
+ * Pushes items in order, so the last one ends up on top. Grows the stack like repeated `push`
+ * calls would, then copies the items at once.
+ *
+ * @param Stack Pointer to stack.
+ * @param items, count Items to be pushed.
+ */
+void push_n(stack* Stack, const int *items, int count) {
+  while (Stack->currP + count >= Stack->size) {
+    reSizeStack(Stack);
+  }
+  memcpy(Stack->arr + Stack->currP, items, count * sizeof(int));
+  Stack->currP += count;
+}
+
+/**
+ * Pops up to `count` items. They are stored bottom to top, so `out[popped - 1]` is the item `pop`
+ * would have returned first.
+ *
+ * @param Stack Pointer to stack.
+ * @param out Array of at least `count` items.
+ * @param count Number of items wanted.
+ *
+ * @return Number of items popped, less than `count` if the stack runs out.
+ */
+int pop_n(stack* Stack, int *out, int count) {
+  if (count > Stack->currP) {
+    count = Stack->currP;
+  }
+  Stack->currP -= count;
+  memcpy(out, Stack->arr + Stack->currP, count * sizeof(int));
+  return count;
+}
+
+/**
+ * View of the stack contents, bottom to top.
+ *
+ * @param Stack Pointer to stack.
+ *
+ * @return Span of the live items.
+ */
+span viewStack(stack* Stack) {
+  span view = {Stack->arr, (size_t)Stack->currP};
+  return view;
+}
+
+/**
+ * Enqueues items in order. The queue grows once to fit them all, then the items are copied in at
+ * most two pieces around the end of the ring.
+ *
+ * @param Queue Pointer to queue.
+ * @param items, count Items to be enqueued.
+ */
+void enq_n(queue* Queue, const int *items, unsigned count) {
+  while (Queue->queueEnd - Queue->currItem + count > Queue->size) {
+    reSizeQueue(Queue);
+  }
+
+  unsigned end = Queue->queueEnd & (Queue->size - 1);
+  unsigned first = Queue->size - end < count ? Queue->size - end : count;
+  memcpy(Queue->arr + end, items, first * sizeof(int));
+  memcpy(Queue->arr, items + first, (count - first) * sizeof(int));
+  Queue->queueEnd += count;
+}
+
+/**
+ * Dequeues up to `count` items in order.
+ *
+ * @param Queue Pointer to queue.
+ * @param out Array of at least `count` items, or NULL to drop the items.
+ * @param count Number of items wanted.
+ *
+ * @return Number of items dequeued, less than `count` if the queue runs out.
+ */
+unsigned deq_n(queue* Queue, int *out, unsigned count) {
+  unsigned available = Queue->queueEnd - Queue->currItem;
+  if (count > available) {
+    count = available;
+  }
+
+  if (out) {
+    unsigned head = Queue->currItem & (Queue->size - 1);
+    unsigned first = Queue->size - head < count ? Queue->size - head : count;
+    memcpy(out, Queue->arr + head, first * sizeof(int));
+    memcpy(out + first, Queue->arr, (count - first) * sizeof(int));
+  }
+  Queue->currItem += count;
+  return count;
+}
+
+/**
+ * View of the queue contents in order. The ring may wrap around, so the items are `parts[0]`
+ * followed by `parts[1]`, the second of which may be empty.
+ *
+ * @param Queue Pointer to queue.
+ * @param parts Array of 2 spans to be filled.
+ */
+void viewQueue(queue* Queue, span parts[2]) {
+  unsigned count = Queue->queueEnd - Queue->currItem;
+  unsigned head = Queue->currItem & (Queue->size - 1);
+  unsigned first = Queue->size - head < count ? Queue->size - head : count;
+
+  parts[0].data = Queue->arr + head;
+  parts[0].length = first;
+  parts[1].data = Queue->arr;
+  parts[1].length = count - first;
+}
+
+/**
+ * Adds two runs of digits, lowest digit first. Digit pairs are summed in a plain loop the
+ * compiler vectorizes, then a second loop carries.
+ *
+ * @param out Array of `n` digits for the sum.
+ * @param a, b Digit arrays, `n` each.
+ * @param n Number of digits.
+ * @param carry Carry into the lowest digit.
+ *
+ * @return Carry out of the highest digit.
+ */
+int addDigits(int *out, const int *a, const int *b, size_t n, int carry) {
+  size_t i = 0;
+  for (; i < n; ++i) {
+    out[i] = a[i] + b[i];
+  }
+  for (i = 0; i < n; ++i) {
+    int digit = out[i] + carry;
+    carry = digit >= 10;
+    out[i] = digit - (carry ? 10 : 0);
+  }
+  return carry;
+}
+
+/**
+ * Adds the digits held in two queues of equal length into `out`, reading them in place through
+ * their views. The queues are left unchanged.
+ *
+ * @param out Array for as many digits as a queue holds.
+ * @param q1, q2 Pointers to queues.
+ *
+ * @return Carry out of the highest digit.
+ */
+int addDigitQueues(int *out, queue* q1, queue* q2) {
+  span a[2], b[2];
+  viewQueue(q1, a);
+  viewQueue(q2, b);
+
+  /* Walk both views in runs that do not cross a wraparound in either queue. */
+  int carry = 0;
+  size_t i = 0, j = 0, offsetA = 0, offsetB = 0;
+  while (i < 2 && j < 2) {
+    size_t run = a[i].length - offsetA < b[j].length - offsetB ? a[i].length - offsetA : b[j].length - offsetB;
+    carry = addDigits(out, a[i].data + offsetA, b[j].data + offsetB, run, carry);
+    out += run;
+    offsetA += run;
+    offsetB += run;
+    if (offsetA == a[i].length) {
+      ++i;
+      offsetA = 0;
+    }
+    if (offsetB == b[j].length) {
+      ++j;
+      offsetB = 0;
+    }
+  }
+  return carry;
+}
+
+/**
+ * Creates a reader on a file.
+ *
+ * @param fp File to read from.
+ *
+ * @return Pointer to newly created reader.
+ */
+digitReader* createReader(FILE *fp) {
+  digitReader *reader = malloc(sizeof(*reader));
+  reader->fp = fp;
+  reader->block = malloc(READ_BLOCK_SIZE);
+  reader->length = 0;
+  reader->pos = 0;
+  return reader;
+}
+
+void freeReader(digitReader* reader) {
+  free(reader->block);
+  free(reader);
+}
+
+/**
+ * Returns the next character of the input, reading a new block when the current one is used up.
+ *
+ * @param reader Pointer to reader.
+ *
+ * @return Next character, EOF at the end of input.
+ */
+int nextChar(digitReader* reader) {
+  if (reader->pos == reader->length) {
+    reader->length = fread(reader->block, 1, READ_BLOCK_SIZE, reader->fp);
+    reader->pos = 0;
+    if (!reader->length) {
+      return EOF;
+    }
+  }
+  return (unsigned char)reader->block[reader->pos++];
+}
+
+/**
+ * Reads a whitespace separated count.
+ *
+ * @param reader Pointer to reader.
+ * @param[out] value Count that was read.
+ *
+ * @return True if a count was read.
+ */
+int readCount(digitReader* reader, size_t *value) {
+  int c = nextChar(reader);
+  while (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+    c = nextChar(reader);
+  }
+  if (c < '0' || c > '9') {
+    return 0;
+  }
+
+  size_t result = 0;
+  while (c >= '0' && c <= '9') {
+    result = result * 10 + (c - '0');
+    c = nextChar(reader);
+  }
+  *value = result;
+  return 1;
+}
+
+/**
+ * Reads single digits, which may or may not be separated by whitespace. Anything else is an error.
+ *
+ * @param reader Pointer to reader.
+ * @param out Array of at least `count` digits.
+ * @param count Number of digits to read.
+ *
+ * @return Number of digits read, less than `count` only at the end of input.
+ */
+size_t readDigits(digitReader* reader, unsigned char *out, size_t count) {
+  size_t i = 0;
+  while (i < count) {
+    int c = nextChar(reader);
+    if (c >= '0' && c <= '9') {
+      out[i++] = (unsigned char)(c - '0');
+    } else if (c == EOF) {
+      break;
+    } else if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+      fprintf(stderr, "Invalid digit '%c'.\n", c);
+      exit(EXIT_FAILURE);
+    }
+  }
+  return i;
+}
+
+/**
+ * Creates an empty spill buffer.
+ *
+ * @param size Number of digits kept in memory.
+ *
+ * @return Pointer to newly created buffer.
+ */
+spill* createSpill(size_t size) {
+  spill *newSpill = malloc(sizeof(*newSpill));
+  newSpill->arr = malloc(size);
+  if (!newSpill->arr) {
+    fputs("Out of memory.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+  newSpill->size = size;
+  newSpill->count = 0;
+  newSpill->file = NULL;
+  newSpill->spilled = 0;
+  newSpill->readPos = 0;
+  return newSpill;
+}
+
+/**
+ * Moves the digits held in memory to the end of the temporary file.
+ *
+ * @param Spill Pointer to spill buffer.
+ */
+void spillToFile(spill* Spill) {
+  if (!Spill->file && !(Spill->file = tmpfile())) {
+    fputs("Cannot create temporary file.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+  if (seekSpill(Spill->file, Spill->spilled) != 0) {
+    fputs("Cannot seek temporary file.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+  if (fwrite(Spill->arr, 1, Spill->count, Spill->file) != Spill->count) {
+    fputs("Cannot write temporary file.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+  Spill->spilled += Spill->count;
+  Spill->count = 0;
+}
+
+/**
+ * Appends digits, spilling the memory part to the file whenever it fills up.
+ *
+ * @param Spill Pointer to spill buffer.
+ * @param digits, count Digits to be appended.
+ */
+void spillPut(spill* Spill, const unsigned char *digits, size_t count) {
+  while (count) {
+    size_t room = Spill->size - Spill->count;
+    size_t part = count < room ? count : room;
+    memcpy(Spill->arr + Spill->count, digits, part);
+    Spill->count += part;
+    digits += part;
+    count -= part;
+    if (Spill->count == Spill->size) {
+      spillToFile(Spill);
+    }
+  }
+}
+
+/**
+ * Reads the next digits in the order they were appended, file part first.
+ *
+ * @param Spill Pointer to spill buffer.
+ * @param out Array of at least `count` digits.
+ * @param count Number of digits wanted.
+ *
+ * @return Number of digits read, less than `count` once all digits were read.
+ */
+size_t spillRead(spill* Spill, unsigned char *out, size_t count) {
+  size_t done = 0;
+  if (Spill->readPos < Spill->spilled) {
+    size_t part = Spill->spilled - Spill->readPos < count ? Spill->spilled - Spill->readPos : count;
+    if (seekSpill(Spill->file, Spill->readPos) != 0) {
+      fputs("Cannot seek temporary file.\n", stderr);
+      exit(EXIT_FAILURE);
+    }
+    if (fread(out, 1, part, Spill->file) != part) {
+      fputs("Cannot read temporary file.\n", stderr);
+      exit(EXIT_FAILURE);
+    }
+    Spill->readPos += part;
+    done = part;
+  }
+
+  size_t held = Spill->spilled + Spill->count - Spill->readPos;
+  size_t part = held < count - done ? held : count - done;
+  memcpy(out + done, Spill->arr + (Spill->readPos - Spill->spilled), part);
+  Spill->readPos += part;
+  return done + part;
+}
+
+/**
+ * Removes digits from the end, newest first, memory part first. Each file read is one block
+ * reversed in place.
+ *
+ * @param Spill Pointer to spill buffer.
+ * @param out Array of at least `count` digits.
+ * @param count Number of digits wanted.
+ *
+ * @return Number of digits popped, less than `count` once the buffer is empty.
+ */
+size_t spillPop(spill* Spill, unsigned char *out, size_t count) {
+  size_t done = 0;
+  while (done < count && Spill->count) {
+    out[done++] = Spill->arr[--Spill->count];
+  }
+  if (done == count || !Spill->spilled) {
+    return done;
+  }
+
+  size_t part = Spill->spilled < count - done ? Spill->spilled : count - done;
+  Spill->spilled -= part;
+  if (seekSpill(Spill->file, Spill->spilled) != 0) {
+    fputs("Cannot seek temporary file.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+  if (fread(out + done, 1, part, Spill->file) != part) {
+    fputs("Cannot read temporary file.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+
+  size_t i = done, j = done + part - 1;
+  for (; i < j; ++i, --j) {
+    unsigned char temp = out[i];
+    out[i] = out[j];
+    out[j] = temp;
+  }
+  return done + part;
+}
+
+void freeSpill(spill* Spill) {
+  if (Spill->file) {
+    fclose(Spill->file);
+  }
+  free(Spill->arr);
+  free(Spill);
+}
+
+/**
+ * Adds a chunk of digits, lowest digit first, like `addDigits` on bytes.
+ *
+ * @param out Array of `n` digits for the sum.
+ * @param a, b Digit arrays, `n` each.
+ * @param n Number of digits.
+ * @param carry Carry into the lowest digit.
+ *
+ * @return Carry out of the highest digit.
+ */
+int addDigitChunk(unsigned char *out, const unsigned char *a, const unsigned char *b, size_t n, int carry) {
+  size_t i = 0;
+  for (; i < n; ++i) {
+    out[i] = a[i] + b[i];
+  }
+  for (i = 0; i < n; ++i) {
+    int digit = out[i] + carry;
+    carry = digit >= 10;
+    out[i] = (unsigned char)(digit - (carry ? 10 : 0));
+  }
+  return carry;
+}
+
+/**
+ * Streaming adder for numbers of any and different lengths. Input is the digit count of number 1,
+ * its digits lowest first, then the same for number 2. Number 1 is kept until number 2 arrives and
+ * the sum until it can be printed highest digit first. Both go through spill buffers, so memory
+ * stays near `budget` bytes however long the numbers are. Unlike the stack adder the carry out of
+ * the top digit is printed.
+ *
+ * @param in File to read from.
+ * @param out File to print to.
+ * @param budget Bytes of digits to keep in memory.
+ */
+void streamAdd(FILE *in, FILE *out, size_t budget) {
+  digitReader *reader = createReader(in);
+  size_t half = budget / 2 > CHUNK_DIGITS ? budget / 2 : CHUNK_DIGITS;
+  spill *first = createSpill(half);
+  spill *sum = createSpill(half);
+  unsigned char *a = malloc(CHUNK_DIGITS);
+  unsigned char *b = malloc(CHUNK_DIGITS);
+  unsigned char *c = malloc(CHUNK_DIGITS);
+  char *text = malloc(2 * CHUNK_DIGITS);
+  size_t n1, n2, i;
+
+  fputs("Enter number 1: ", out);
+  if (!readCount(reader, &n1)) {
+    fputs("Illegal size!\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+  for (i = 0; i < n1; i += CHUNK_DIGITS) {
+    size_t part = n1 - i < CHUNK_DIGITS ? n1 - i : CHUNK_DIGITS;
+    if (readDigits(reader, a, part) != part) {
+      fputs("Missing digits.\n", stderr);
+      exit(EXIT_FAILURE);
+    }
+    spillPut(first, a, part);
+  }
+
+  fputs("\nEnter number 2: ", out);
+  if (!readCount(reader, &n2)) {
+    fputs("Illegal size!\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+  size_t longest = n1 > n2 ? n1 : n2;
+  int carry = 0;
+  for (i = 0; i < longest; i += CHUNK_DIGITS) {
+    size_t part = longest - i < CHUNK_DIGITS ? longest - i : CHUNK_DIGITS;
+    size_t got = spillRead(first, a, part);
+    memset(a + got, 0, part - got);
+
+    got = 0;
+    if (i < n2) {
+      size_t wanted = n2 - i < part ? n2 - i : part;
+      if ((got = readDigits(reader, b, wanted)) != wanted) {
+        fputs("Missing digits.\n", stderr);
+        exit(EXIT_FAILURE);
+      }
+    }
+    memset(b + got, 0, part - got);
+
+    carry = addDigitChunk(c, a, b, part, carry);
+    spillPut(sum, c, part);
+  }
+  if (carry) {
+    c[0] = 1;
+    spillPut(sum, c, 1);
+  }
+
+  fputs("\nSum: ", out);
+  size_t got;
+  while ((got = spillPop(sum, c, CHUNK_DIGITS))) {
+    for (i = 0; i < got; ++i) {
+      text[2 * i] = (char)('0' + c[i]);
+      text[2 * i + 1] = ' ';
+    }
+    fwrite(text, 1, 2 * got, out);
+  }
+
+  free(a);
+  free(b);
+  free(c);
+  free(text);
+  freeSpill(first);
+  freeSpill(sum);
+  freeReader(reader);
+}
+
+#ifdef _OPENMP
+/**
+ * Creates a lock-free queue. Unlike `queue` it cannot grow, so it must be sized for the items
+ * the producer may run ahead by.
+ *
+ * @param size Number of items, rounded up to a power of two.
+ *
+ * @return Pointer to newly created queue.
+ */
+spscQueue* createSpscQueue(int size) {
+  unsigned capacity = 1;
+  while (capacity < (unsigned)size) {
+    capacity *= 2;
+  }
+
+#ifdef _MSC_VER
+  spscQueue *newQueue = _aligned_malloc(sizeof(*newQueue), CACHE_LINE);
+#else
+  spscQueue *newQueue = aligned_alloc(CACHE_LINE, sizeof(*newQueue));
+#endif
+  int *arr = malloc(capacity * sizeof(int));
+  if (!newQueue || !arr) {
+    fputs("Out of memory.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+  newQueue->arr = arr;
+  newQueue->size = capacity;
+  atomic_init(&newQueue->tail, 0);
+  newQueue->pending = 0;
+  newQueue->headCache = 0;
+  atomic_init(&newQueue->head, 0);
+  newQueue->taken = 0;
+  newQueue->tailCache = 0;
+  return newQueue;
+}
+
+/**
+ * Backs off while waiting on the other thread: busy spins first, then yields.
+ *
+ * @param spins Spin counter of the current wait, starts at 0.
+ */
+void spinWait(int *spins) {
+  if (++*spins < SPIN_LIMIT) {
+    return;
+  }
+  *spins = 0;
+#ifndef _WIN32
+  sched_yield();
+#endif
+}
+
+/**
+ * Makes all enqueued items visible to the consumer.
+ *
+ * @param Queue Pointer to queue, called from the producer thread only.
+ */
+void spscFlush(spscQueue* Queue) {
+  atomic_store_explicit(&Queue->tail, Queue->pending, memory_order_release);
+}
+
+/**
+ * Enqueues an item, waiting while the queue is full. Items become visible in batches, call
+ * `spscFlush` after the last one.
+ *
+ * @param Queue Pointer to queue, called from the producer thread only.
+ * @param newItem Item to be enqueued.
+ */
+void spscEnq(spscQueue* Queue, int newItem) {
+  unsigned end = Queue->pending;
+  if (end - Queue->headCache == Queue->size) {
+    int spins = 0;
+    spscFlush(Queue);
+    while (end - (Queue->headCache = atomic_load_explicit(&Queue->head, memory_order_acquire)) == Queue->size) {
+      spinWait(&spins);
+    }
+  }
+
+  Queue->arr[end & (Queue->size - 1)] = newItem;
+  Queue->pending = ++end;
+  if (!(end & (SPSC_BATCH - 1))) {
+    spscFlush(Queue);
+  }
+}
+
+/**
+ * Dequeues an item, waiting while the queue is empty.
+ *
+ * @param Queue Pointer to queue, called from the consumer thread only.
+ *
+ * @return The oldest item.
+ */
+int spscDeq(spscQueue* Queue) {
+  unsigned item = Queue->taken;
+  if (item == Queue->tailCache) {
+    int spins = 0;
+    atomic_store_explicit(&Queue->head, item, memory_order_release);
+    while (item == (Queue->tailCache = atomic_load_explicit(&Queue->tail, memory_order_acquire))) {
+      spinWait(&spins);
+    }
+  }
+
+  int value = Queue->arr[item & (Queue->size - 1)];
+  Queue->taken = ++item;
+  if (!(item & (SPSC_BATCH - 1))) {
+    atomic_store_explicit(&Queue->head, item, memory_order_release);
+  }
+  return value;
+}
+
+void freeSpscQueue(spscQueue* Queue) {
+  free(Queue->arr);
+#ifdef _MSC_VER
+  _aligned_free(Queue);
+#else
+  free(Queue);
+#endif
+}
+#endif
+
+
+#ifndef BENCHMARK
+int main(int argc, char *argv[]) {
+  int stream = 0;
+  size_t budget = MEMORY_BUDGET;
+  int arg = 1;
+  for (; arg < argc; ++arg) {
+    if (strcmp(argv[arg], "--stream") == 0) {
+      stream = 1;
+    } else if (strcmp(argv[arg], "--budget") == 0 && arg + 1 < argc) {
+      budget = strtoull(argv[++arg], NULL, 10);
+    } else {
+      fprintf(stderr, "Unknown option %s.\n", argv[arg]);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if (stream) {
+    streamAdd(stdin, stdout, budget);
+    return 0;
+  }
+
   fputs("Enter queue size: ", stdout);
   int n;
   fscanf(stdin, "%d", &n);
@@ -128,41 +883,88 @@ int main() {
     exit(-1);
   }
 
+  size_t i = 0;
+  stack *s = createStack(n);
+
+#ifdef _OPENMP
+  size_t carry = 0;
+
+  /*
+   * The reader streams digits to the adder. Both queues hold all n digits: the adder needs
+   * number 2 before the reader is done with number 1, and a single thread runs the reader first.
+   */
+  spscQueue *q1 = createSpscQueue(n);
+  spscQueue *q2 = createSpscQueue(n);
+
+  #pragma omp parallel sections num_threads(2) private(i)
+  {
+    #pragma omp section
+    {
+      fputs("\nEnter queue 1: ", stdout);
+      for (i = 0; i < n; ++i) {
+        int temp;
+        fscanf(stdin, "%d", &temp);
+        spscEnq(q1, temp);
+      }
+      spscFlush(q1);
+
+      fputs("\nEnter queue 2: ", stdout);
+      for (i = 0; i < n; ++i) {
+        int temp;
+        fscanf(stdin, "%d", &temp);
+        spscEnq(q2, temp);
+      }
+      spscFlush(q2);
+    }
+
+    #pragma omp section
+    for (i = 0; i < n; ++i) {
+      int digit_sum = spscDeq(q1) + spscDeq(q2);
+      push(s, (digit_sum + carry) % 10);
+
+      carry = (digit_sum+carry >= 10) ? 1 : 0;
+    }
+  }
+
+  freeSpscQueue(q1);
+  freeSpscQueue(q2);
+#else
   queue *q1 = createQueue(n);
   queue *q2 = createQueue(n);
-
-  size_t i = 0;
+  int *digits = malloc(n * sizeof(int));
 
   fputs("\nEnter queue 1: ", stdout);
   for (i = 0; i < n; ++i) {
-    int temp;
-    fscanf(stdin, "%d", &temp);
-    enq(q1, temp);
+    fscanf(stdin, "%d", &digits[i]);
   }
+  enq_n(q1, digits, n);
 
   fputs("\nEnter queue 2: ", stdout);
   for (i = 0; i < n; ++i) {
-    int temp;
-    fscanf(stdin, "%d", &temp);
-    enq(q2, temp);
+    fscanf(stdin, "%d", &digits[i]);
   }
+  enq_n(q2, digits, n);
 
+  /* Like the digit loop, the carry out of the top digit is dropped. */
+  addDigitQueues(digits, q1, q2);
+  deq_n(q1, NULL, n);
+  deq_n(q2, NULL, n);
+  push_n(s, digits, n);
 
-  stack *s = createStack(n);
-
-  size_t carry = 0;
-
-  for (i = 0; i < n; ++i) {
-    int digit_sum = deq(q1) + deq(q2);
-    push(s, (digit_sum + carry) % 10);
-
-    carry = (digit_sum+carry >= 10) ? 1 : 0;
-  }
+  free(digits);
+  freeQueue(q1);
+  freeQueue(q2);
+#endif
 
   fputs("\nSum: ", stdout);
-  for (i = 0; i < n; ++i) {
-    fprintf(stdout, "%d ", pop(s));
+  int *sum = malloc(n * sizeof(int));
+  int popped = pop_n(s, sum, n);
+  while (popped-- > 0) {
+    fprintf(stdout, "%d ", sum[popped]);
   }
+  free(sum);
 
+  freeStack(s);
 	return 0;
 }
+#endif
@@ -1,39 +1,1415 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <math.h>
+#include <stdint.h>
+#include <limits.h>
+#include <string.h>
 
 /*
  * Given a binary search tree represented as an array, find maximum element, its level, and its
  * cousin node values.
  */
 
+/* Keys per cache line, the descent prefetches a whole line of descendants this many nodes deep. */
+#define LINE_KEYS 16
+
+/* Queries a batch search walks down the tree side by side. */
+#define BATCH_WIDTH 32
+/* Bit words per 64 byte line of the succinct tree, the other two words of a line are its rank counts. */
+#define LINE_WORDS 6
+/* The succinct tree remembers the line of every this many-th set bit to start `select` near it. */
+#define SELECT_SAMPLE 512
+/* Slots per segment of a dynamic set, four cache lines that an insert shifts with one memmove. */
+#define SEGMENT_SIZE 64
+
+#ifdef __GNUC__
+#define PREFETCH(address) __builtin_prefetch(address)
+#else
+#define PREFETCH(address) ((void)0)
+#endif
+
+/*
+ * `simd` loop hints, so the per-level scans compare several keys per instruction. GCC 12 at -O2
+ * only vectorizes them when given -fopenmp, or -fopenmp-simd with -DOPENMP_SIMD; other builds leave
+ * the hints out instead of warning about an unknown pragma.
+ */
+#if defined(_OPENMP) || defined(OPENMP_SIMD)
+#define OMP(directive) _Pragma(OMP_TEXT(omp directive))
+#define OMP_TEXT(text) #text
+#else
+#define OMP(directive)
+#endif
+
+/*
+ * Complete binary search tree in Eytzinger (BFS) order with no holes: the children of `keys[i]`
+ * are `keys[2i + 1]` and `keys[2i + 2]`. `keys` is placed one past a 64 byte boundary, so the 16
+ * descendants four levels below a node share one cache line.
+ */
+typedef struct {
+  int *keys;
+  size_t n;
+  int *block;
+  int height;         /* Levels, the last one possibly partial. */
+  size_t lastLevel;   /* Nodes present on the last level. */
+} SearchTree;
+
+/*
+ * Tree with no room for holes. The present nodes are numbered in level order from 0 and `values`
+ * holds their values in that order. `bits` has two bits per node, set if its left and right
+ * child are present. Node `j > 0` is the `j`th set bit, so the child behind bit `b` is
+ * `rank(b + 1)` and the parent of node `j` is `select(j) / 2`. The bits are stored in 64 byte
+ * lines together with their rank counts, so rank reads one line and does one popcount.
+ */
+typedef struct {
+  uint64_t *lines;        /* Per line: set bits before it, 9 bit counts before its words 1-5, 6 words of bits. */
+  size_t lineCount;       /* Lines, the last one only holds the total count. */
+  size_t slots;           /* Bits in use, twice the node count. */
+  size_t *samples;        /* Line of set bit 1, SELECT_SAMPLE + 1, ... */
+  int *values;
+  size_t count;
+  size_t *levelStarts;    /* First node of each level, plus `count` at the end. */
+  size_t height;
+} SuccinctTree;
+
+/*
+ * Ordered set of distinct keys in a packed memory array: `segments` runs of SEGMENT_SIZE slots,
+ * each with its `sizes[s]` keys packed at its start and the rest left free for inserts. Aligned
+ * ranges of segments form an implicit tree. When a segment overflows or runs low, the keys of the
+ * smallest range around it that is within its density bounds are spread evenly over it; if even
+ * the whole array is out of bounds it doubles or halves. `index` is a SearchTree over the largest
+ * key of every segment, patched in place and rebuilt when the array changes size, and `counts` is
+ * a Fenwick tree of the segment sizes for ranks.
+ */
+typedef struct {
+  int *slots;
+  size_t *sizes;
+  size_t segments;    /* Power of two. */
+  size_t count;
+  SearchTree *index;  /* An empty segment repeats the largest key before it, INT_MIN if none. */
+  size_t *counts;
+  int *scratch;       /* Room for every slot plus one, keys of a range are spread from here. */
+} DynamicSet;
+
+size_t treeLevel(size_t);
+size_t treeParent(size_t);
+size_t treeSibling(size_t);
+size_t levelStart(size_t);
+size_t levelEnd(size_t);
+size_t subtreeStart(size_t, size_t);
+size_t subtreeEnd(size_t, size_t);
+int levelMax(int[], size_t, size_t);
+size_t levelCount(int[], size_t, size_t);
+size_t cousinCount(int[], size_t, size_t);
+void printCousins(int[], size_t, size_t);
+void *alignedAlloc(size_t, size_t);
+void alignedFree(void *);
+SearchTree *createSearchTree(const int *, size_t);
+size_t fillEytzinger(SearchTree *, const int *, size_t, size_t);
+void freeSearchTree(SearchTree *);
+size_t collectKeys(int[], size_t, int *);
+int floorLog2(size_t);
+size_t lastLeftTurn(size_t);
+size_t searchLowerBound(SearchTree *, int);
+size_t searchUpperBound(SearchTree *, int);
+size_t searchFind(SearchTree *, int);
+void searchLowerBoundBatch(SearchTree *, const int *, size_t, size_t *);
+size_t searchRank(SearchTree *, size_t);
+size_t searchNode(SearchTree *, size_t);
+size_t searchCount(SearchTree *, int, int);
+int popCount(uint64_t);
+SuccinctTree *createSuccinctTree(int[], size_t);
+void freeSuccinctTree(SuccinctTree *);
+size_t succinctSize(SuccinctTree *);
+uint64_t *bitWord(SuccinctTree *, size_t);
+size_t rankOnes(SuccinctTree *, size_t);
+size_t selectOne(SuccinctTree *, size_t);
+size_t succinctChild(SuccinctTree *, size_t, int);
+size_t succinctParent(SuccinctTree *, size_t);
+size_t succinctLevel(SuccinctTree *, size_t);
+size_t succinctPosition(SuccinctTree *, size_t);
+size_t succinctFind(SuccinctTree *, int);
+DynamicSet *createDynamicSet(void);
+void freeDynamicSet(DynamicSet *);
+void resizeDynamicSet(DynamicSet *, size_t, const int *);
+void rebuildIndex(DynamicSet *);
+void refreshHeads(DynamicSet *, size_t, size_t);
+void countAdd(DynamicSet *, size_t, size_t);
+size_t countBefore(DynamicSet *, size_t);
+size_t gatherKeys(DynamicSet *, size_t, size_t, int *);
+size_t insertSorted(int *, size_t, int);
+void spreadKeys(DynamicSet *, size_t, size_t, const int *, size_t);
+void rebalanceSegments(DynamicSet *, size_t, const int *);
+size_t locateSegment(DynamicSet *, int);
+size_t segmentLowerBound(const int *, size_t, int);
+int dynamicInsert(DynamicSet *, int);
+int dynamicErase(DynamicSet *, int);
+size_t dynamicEnd(DynamicSet *);
+size_t dynamicLowerBound(DynamicSet *, int);
+size_t dynamicUpperBound(DynamicSet *, int);
+size_t dynamicFind(DynamicSet *, int);
+size_t dynamicRank(DynamicSet *, size_t);
+size_t dynamicCount(DynamicSet *, int, int);
+
 void findMax(int tree[], size_t N) {
   /* Initial condition, max elem is root. */
   int max = tree[0];
-  int idx_max = 0;
+  size_t idx_max = 0;
+
+  size_t i = 2;
+  for (; i < N && tree[i] != -1; i = i*2 + 2) {    /* Always traverse to right child. */
+    max = tree[i];
+    idx_max = i;
+  }
+
+  fprintf(stdout, "Max: %d\n", max);
+  fprintf(stdout, "Level: %llu\n", (unsigned long long)treeLevel(idx_max));
+
+  fputs("Cousins: ", stdout);
+  printCousins(tree, N, idx_max);
+}
+
+/*
+ * Navigation of array trees. Nodes are indexed from 0 with children at 2i + 1 and 2i + 2, levels
+ * are counted from 1 at the root as `findMax` prints them. Node `i` is node `i + 1` of the same
+ * tree numbered from 1, where the level is the bit length and the parent drops the lowest bit.
+ */
+
+/**
+ * Level of a node, the root is on level 1.
+ *
+ * @param i Node index.
+ *
+ * @return Level of the node.
+ */
+size_t treeLevel(size_t i) {
+  return (size_t)floorLog2(i + 1) + 1;
+}
+
+/**
+ * Parent of a node.
+ *
+ * @param i Node index, not the root.
+ *
+ * @return Index of the parent.
+ */
+size_t treeParent(size_t i) {
+  return (i - 1) / 2;
+}
+
+/**
+ * Other child of a node's parent.
+ *
+ * @param i Node index, not the root.
+ *
+ * @return Index of the sibling, may be past the end of the array.
+ */
+size_t treeSibling(size_t i) {
+  return ((i - 1) ^ 1) + 1;
+}
+
+/**
+ * First index of a level.
+ *
+ * @param level Level, 1 for the root.
+ *
+ * @return Index of the leftmost node of the level.
+ */
+size_t levelStart(size_t level) {
+  return ((size_t)1 << (level - 1)) - 1;
+}
+
+/**
+ * End of a level, the first index of the next one.
+ *
+ * @param level Level, 1 for the root.
+ *
+ * @return Index one past the rightmost node of the level.
+ */
+size_t levelEnd(size_t level) {
+  return ((size_t)1 << level) - 1;
+}
+
+/**
+ * First index of a node's descendants `depth` levels down. They are consecutive and there are
+ * `2^depth` of them.
+ *
+ * @param i Node index.
+ * @param depth Levels below the node, 0 is the node itself.
+ *
+ * @return Index of the leftmost descendant.
+ */
+size_t subtreeStart(size_t i, size_t depth) {
+  return ((i + 1) << depth) - 1;
+}
+
+/**
+ * End of a node's descendants `depth` levels down.
+ *
+ * @param i Node index.
+ * @param depth Levels below the node, 0 is the node itself.
+ *
+ * @return Index one past the rightmost descendant.
+ */
+size_t subtreeEnd(size_t i, size_t depth) {
+  return ((i + 2) << depth) - 1;
+}
+
+/**
+ * Largest value on a level, holes (`-1`) left out. The loop has no branches so it vectorizes.
+ *
+ * @param tree Array tree.
+ * @param N Size of the array.
+ * @param level Level to be scanned.
+ *
+ * @return Largest value, -1 if the level has no nodes.
+ */
+int levelMax(int tree[], size_t N, size_t level) {
+  size_t start = levelStart(level) < N ? levelStart(level) : N;
+  size_t end = levelEnd(level) < N ? levelEnd(level) : N;
+  int max = -1;
+  size_t i;
+  OMP(simd reduction(max:max))
+  for (i = start; i < end; ++i) {
+    max = tree[i] > max ? tree[i] : max;
+  }
+  return max;
+}
+
+/**
+ * Number of nodes on a level, holes (`-1`) left out.
+ *
+ * @param tree Array tree.
+ * @param N Size of the array.
+ * @param level Level to be scanned.
+ *
+ * @return Number of nodes.
+ */
+size_t levelCount(int tree[], size_t N, size_t level) {
+  size_t start = levelStart(level) < N ? levelStart(level) : N;
+  size_t end = levelEnd(level) < N ? levelEnd(level) : N;
+  size_t count = 0;
+  size_t i;
+  OMP(simd reduction(+:count))
+  for (i = start; i < end; ++i) {
+    count += tree[i] != -1;
+  }
+  return count;
+}
+
+/**
+ * Number of cousins of a node: nodes on its level that are not children of its parent.
+ *
+ * @param tree Array tree.
+ * @param N Size of the array.
+ * @param i Node index.
+ *
+ * @return Number of cousins.
+ */
+size_t cousinCount(int tree[], size_t N, size_t i) {
+  if (!i) {
+    return 0;
+  }
+
+  size_t first = subtreeStart(treeParent(i), 1);
+  size_t count = levelCount(tree, N, treeLevel(i));
+  count -= first < N && tree[first] != -1;
+  count -= first + 1 < N && tree[first + 1] != -1;
+  return count;
+}
+
+/**
+ * Prints the cousins of a node left to right: nodes on its level that are not children of its
+ * parent. The level is walked as two plain ranges around the parent's children.
+ *
+ * @param tree Array tree.
+ * @param N Size of the array.
+ * @param i Node index.
+ */
+void printCousins(int tree[], size_t N, size_t i) {
+  if (!i) {
+    return;
+  }
+
+  size_t level = treeLevel(i);
+  size_t start = levelStart(level);
+  size_t end = levelEnd(level) < N ? levelEnd(level) : N;
+  size_t first = subtreeStart(treeParent(i), 1);
+  size_t j = start;
+  for (; j < first && j < end; ++j) {
+    if (tree[j] != -1) {
+      fprintf(stdout, "%d ", tree[j]);
+    }
+  }
+  for (j = first + 2; j < end; ++j) {
+    if (tree[j] != -1) {
+      fprintf(stdout, "%d ", tree[j]);
+    }
+  }
+}
+
+/**
+ * Allocates memory that starts on a multiple of `alignment`, `_aligned_malloc` stands in for
+ * `aligned_alloc` on MSVC. Free it with `alignedFree`.
+ *
+ * @param alignment Power of two the address is a multiple of.
+ * @param bytes Size of the memory, a multiple of `alignment`.
+ *
+ * @return Pointer to the memory, NULL if it could not be allocated.
+ */
+void *alignedAlloc(size_t alignment, size_t bytes) {
+#ifdef _MSC_VER
+  return _aligned_malloc(bytes, alignment);
+#else
+  return aligned_alloc(alignment, bytes);
+#endif
+}
+
+/**
+ * Frees memory from `alignedAlloc`.
+ *
+ * @param block Pointer to the memory, may be NULL.
+ */
+void alignedFree(void *block) {
+#ifdef _MSC_VER
+  _aligned_free(block);
+#else
+  free(block);
+#endif
+}
 
+/**
+ * Builds a search tree from sorted keys in O(n). Keys may repeat.
+ *
+ * @param sorted Keys in non-decreasing order.
+ * @param n Number of keys.
+ *
+ * @return Pointer to newly created SearchTree object.
+ */
+SearchTree *createSearchTree(const int *sorted, size_t n) {
+  SearchTree *tree = malloc(sizeof(*tree));
+  size_t bytes = ((n + LINE_KEYS) * sizeof(int) + 63) / 64 * 64;
+  if (!tree || !(tree->block = alignedAlloc(64, bytes))) {
+    fputs("Out of memory.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+  tree->keys = tree->block + 1;
+  tree->n = n;
+
+  tree->height = 0;
+  size_t full = 0;
+  while (full < n) {
+    full = full * 2 + 1;
+    ++tree->height;
+  }
+  tree->lastLevel = n - full / 2;
+
+  fillEytzinger(tree, sorted, 0, 1);
+  return tree;
+}
+
+/**
+ * Places sorted keys into the subtree of a node by an in-order walk. Nodes are numbered from 1
+ * here, node `k` lives at `keys[k - 1]`.
+ *
+ * @param tree Pointer to tree object.
+ * @param sorted Keys in non-decreasing order.
+ * @param next Index of the next key to be placed.
+ * @param k Root of the subtree.
+ *
+ * @return Index of the next key to be placed after the subtree.
+ */
+size_t fillEytzinger(SearchTree *tree, const int *sorted, size_t next, size_t k) {
+  if (k <= tree->n) {
+    next = fillEytzinger(tree, sorted, next, 2 * k);
+    tree->keys[k - 1] = sorted[next++];
+    next = fillEytzinger(tree, sorted, next, 2 * k + 1);
+  }
+  return next;
+}
+
+/**
+ * Frees a search tree and its keys.
+ *
+ * @param tree Pointer to tree object to be freed.
+ */
+void freeSearchTree(SearchTree *tree) {
+  if (!tree) {
+    return;
+  }
+
+  alignedFree(tree->block);
+  free(tree);
+}
+
+/**
+ * Collects the keys of an array-represented BST with `-1` holes in sorted order, ready for
+ * `createSearchTree`.
+ *
+ * @param tree Array-represented BST.
+ * @param N Size of the array.
+ * @param out Array of at least `N` keys.
+ *
+ * @return Number of keys collected.
+ */
+size_t collectKeys(int tree[], size_t N, int *out) {
+  size_t count = 0;
   size_t i = 0;
-  for (; i < N; i = i*2 + 2) {    /* Always traverse to right child. */
-    if (tree[i] != -1) {
-      max = tree[i];
-      idx_max = i;
+  /* Iterative in-order walk: go left while possible, then take the node and step to its successor. */
+  while (i < N && tree[i] != -1) {
+    i = 2 * i + 1;
+  }
+  i = (i - 1) / 2;
+  while (i < N) {
+    out[count++] = tree[i];
+    size_t right = 2 * i + 2;
+    if (right < N && tree[right] != -1) {
+      i = right;
+      while (2 * i + 1 < N && tree[2 * i + 1] != -1) {
+        i = 2 * i + 1;
+      }
+    } else {
+      /* Climb while coming from a right child, the parent of a left child is next. */
+      while (i && i % 2 == 0) {
+        i = (i - 1) / 2;
+      }
+      i = i ? (i - 1) / 2 : N;
     }
   }
+  return count;
+}
+
+/**
+ * Index of the highest set bit.
+ *
+ * @param x Non-zero value.
+ *
+ * @return `floor(log2(x))`.
+ */
+int floorLog2(size_t x) {
+#ifdef __GNUC__
+  return 63 - __builtin_clzll((unsigned long long)x);
+#else
+  int bit = 0;
+  while (x >>= 1) {
+    ++bit;
+  }
+  return bit;
+#endif
+}
 
-  size_t level = (size_t)ceil(log(idx_max)/log(2));   /* lg(index) rounded up. */
-  int parent = (idx_max-1) / 2;
+/**
+ * Drops the trailing 1 bits of a descent path plus the 0 above them, which leads back to the
+ * last node where the descent went left.
+ *
+ * @param k Node number the descent ended at, past the leaves.
+ *
+ * @return That node, 0 if the descent never went left.
+ */
+size_t lastLeftTurn(size_t k) {
+#ifdef __GNUC__
+  return k >> (__builtin_ctzll(~(unsigned long long)k) + 1);
+#else
+  while (k & 1) {
+    k >>= 1;
+  }
+  return k >> 1;
+#endif
+}
 
-  fprintf(stdout, "Max: %d\n", max);
-  fprintf(stdout, "Level: %llu\n", level);
+/**
+ * Finds the first key not less than `key`. The descent has no branch on the comparison and
+ * prefetches the line of nodes four levels down.
+ *
+ * @param tree Pointer to tree object.
+ * @param key Key to be searched.
+ *
+ * @return Index in `keys`, `n` if every key is less.
+ */
+size_t searchLowerBound(SearchTree *tree, int key) {
+  size_t k = 1;
+  while (k <= tree->n) {
+    PREFETCH(tree->keys + LINE_KEYS * k - 1);
+    k = 2 * k + (tree->keys[k - 1] < key);
+  }
+  k = lastLeftTurn(k);
+  return k ? k - 1 : tree->n;
+}
 
-  fputs("Cousins: ", stdout);
-  for (i = pow(2, level-1) - 1; i < pow(2, level) - 1; ++i) {       /* Traverse in level 4, printing values that are    */
-    if (i != parent*2 + 1 && i != parent*2 + 2 && tree[i] != -1) {  /* not -1 and not children of max element's parent  */
-      fprintf(stdout, "%d ", tree[i]);
+/**
+ * Finds the first key greater than `key`, like `searchLowerBound`.
+ *
+ * @param tree Pointer to tree object.
+ * @param key Key to be searched.
+ *
+ * @return Index in `keys`, `n` if no key is greater.
+ */
+size_t searchUpperBound(SearchTree *tree, int key) {
+  size_t k = 1;
+  while (k <= tree->n) {
+    PREFETCH(tree->keys + LINE_KEYS * k - 1);
+    k = 2 * k + (tree->keys[k - 1] <= key);
+  }
+  k = lastLeftTurn(k);
+  return k ? k - 1 : tree->n;
+}
+
+/**
+ * `searchLowerBound` for many keys. Groups of `BATCH_WIDTH` queries descend together one level at
+ * a time: the group's loads of a level are independent, so their cache misses overlap instead of
+ * queuing up, and the level's compares form one loop that vectorizes. The top `height - 1` levels
+ * are complete, every query steps through them without a bounds check, only the last, partial
+ * level needs one. Node numbers are kept in 32 bits, compilers only vectorize the key loads
+ * (gathers) with index and key of equal width, so trees past 2^31 keys fall back to single
+ * searches.
+ *
+ * @param tree Pointer to tree object.
+ * @param queries Keys to be searched.
+ * @param count Number of keys.
+ * @param[out] results Array of `count` indices, as `searchLowerBound` returns them.
+ */
+void searchLowerBoundBatch(SearchTree *tree, const int *queries, size_t count, size_t *results) {
+  const int *keys = tree->keys;
+  size_t n = tree->n;
+  uint32_t k[BATCH_WIDTH];
+  size_t first = 0;
+  if (n >= (size_t)1 << 31) {
+    for (; first < count; ++first) {
+      results[first] = searchLowerBound(tree, queries[first]);
     }
+    return;
+  }
+
+  for (; first < count; first += BATCH_WIDTH) {
+    size_t width = count - first < BATCH_WIDTH ? count - first : BATCH_WIDTH;
+    const int *q = queries + first;
+    size_t j;
+
+    for (j = 0; j < width; ++j) {
+      k[j] = 1;
+    }
+
+    int level = 1;
+    for (; level < tree->height; ++level) {
+      OMP(simd)
+      for (j = 0; j < width; ++j) {
+        k[j] = 2 * k[j] + (keys[k[j] - 1] < q[j]);
+      }
+    }
+
+    /* Partial last level, written without branches so it vectorizes: nodes past `n` load the
+     * root key and keep their number. */
+    uint32_t last = (uint32_t)n;
+    OMP(simd)
+    for (j = 0; j < width; ++j) {
+      uint32_t node = k[j];
+      uint32_t inside = node <= last;
+      int key = keys[inside * (node - 1)];
+      k[j] = node + inside * (node + (key < q[j]));
+    }
+
+    for (j = 0; j < width; ++j) {
+      size_t turn = lastLeftTurn(k[j]);
+      results[first + j] = turn ? turn - 1 : n;
+    }
+  }
+}
+
+/**
+ * Looks up a key.
+ *
+ * @param tree Pointer to tree object.
+ * @param key Key to be searched.
+ *
+ * @return Index of the key in `keys`, `n` if it is not there.
+ */
+size_t searchFind(SearchTree *tree, int key) {
+  size_t i = searchLowerBound(tree, key);
+  return i < tree->n && tree->keys[i] == key ? i : tree->n;
+}
+
+/**
+ * Turns an index in `keys` into the number of keys before it in sorted order. In a perfect tree
+ * of `height` levels, node `j` of level `d` comes at `(2j + 1) * 2^(height - d) - 1`. The last
+ * level nodes sit at the even positions, so the ones missing before that position are taken out.
+ *
+ * @param tree Pointer to tree object.
+ * @param i Index in `keys`, `n` stands for past the end.
+ *
+ * @return Sorted rank, `n` for past the end.
+ */
+size_t searchRank(SearchTree *tree, size_t i) {
+  if (i >= tree->n) {
+    return tree->n;
+  }
+
+  size_t k = i + 1;
+  int depth = floorLog2(k);
+  size_t offset = k - ((size_t)1 << depth);
+  size_t position = ((2 * offset + 1) << (tree->height - 1 - depth)) - 1;
+  size_t before = (position + 1) / 2;
+  return before > tree->lastLevel ? position - (before - tree->lastLevel) : position;
+}
+
+/**
+ * Turns a sorted rank into an index in `keys`, the inverse of `searchRank`. The position in the
+ * perfect tree is found first, its trailing 1 bits (counted from 1) give the height above the last
+ * level and the bits above them the offset within the level.
+ *
+ * @param tree Pointer to tree object.
+ * @param rank Sorted rank, less than `n`.
+ *
+ * @return Index in `keys`.
+ */
+size_t searchNode(SearchTree *tree, size_t rank) {
+  size_t position = rank < 2 * tree->lastLevel ? rank : 2 * (rank - tree->lastLevel) + 1;
+  size_t k = position + 1;
+#ifdef __GNUC__
+  int up = __builtin_ctzll((unsigned long long)k);
+#else
+  int up = 0;
+  while (!(k >> up & 1)) {
+    ++up;
+  }
+#endif
+  int depth = tree->height - 1 - up;
+  return ((size_t)1 << depth) + (k >> (up + 1)) - 1;
+}
+
+/**
+ * Counts the keys in a closed range.
+ *
+ * @param tree Pointer to tree object.
+ * @param low, high Bounds of the range.
+ *
+ * @return Number of keys `x` with `low <= x <= high`.
+ */
+size_t searchCount(SearchTree *tree, int low, int high) {
+  if (low > high) {
+    return 0;
+  }
+  return searchRank(tree, searchUpperBound(tree, high)) - searchRank(tree, searchLowerBound(tree, low));
+}
+
+/**
+ * Number of set bits.
+ *
+ * @param x Word.
+ *
+ * @return Number of 1 bits in `x`.
+ */
+int popCount(uint64_t x) {
+#if defined(__GNUC__) && defined(__POPCNT__)
+  return __builtin_popcountll(x);
+#else
+  x = x - ((x >> 1) & 0x5555555555555555ull);
+  x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+  x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+  return (int)((x * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+/**
+ * Builds the succinct form of an array-represented tree with `-1` holes, visiting the present
+ * nodes in level order.
+ *
+ * @param tree Array tree.
+ * @param N Size of the array.
+ *
+ * @return Pointer to newly created SuccinctTree object.
+ */
+SuccinctTree *createSuccinctTree(int tree[], size_t N) {
+  size_t count = N ? levelCount(tree, N, 1) : 0;
+  size_t level = 2;
+  for (; levelStart(level) < N; ++level) {
+    count += levelCount(tree, N, level);
+  }
+
+  SuccinctTree *succinct = malloc(sizeof(*succinct));
+  if (!succinct) {
+    fputs("Out of memory.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+  succinct->slots = 2 * count;
+  succinct->lineCount = succinct->slots / (64 * LINE_WORDS) + 2;
+  succinct->lines = alignedAlloc(64, succinct->lineCount * 64);
+  succinct->samples = malloc((count / SELECT_SAMPLE + 1) * sizeof(size_t));
+  succinct->values = malloc((count ? count : 1) * sizeof(int));
+  succinct->levelStarts = malloc((level + 1) * sizeof(size_t));
+  succinct->count = count;
+  succinct->height = 0;
+  size_t *positions = malloc((count ? count : 1) * sizeof(size_t));
+  if (!succinct->lines || !succinct->samples || !succinct->values || !succinct->levelStarts || !positions) {
+    fputs("Out of memory.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+  memset(succinct->lines, 0, succinct->lineCount * 64);
+
+  /* Breadth first walk, `positions` doubles as the queue of array indices. */
+  size_t tail = 0;
+  if (count) {
+    positions[tail++] = 0;
+  }
+  size_t head = 0;
+  for (; head < tail; ++head) {
+    size_t i = positions[head];
+    if (treeLevel(i) > succinct->height) {
+      succinct->levelStarts[succinct->height++] = head;
+    }
+    succinct->values[head] = tree[i];
+
+    size_t side = 0;
+    for (; side < 2; ++side) {
+      size_t child = 2 * i + 1 + side;
+      if (child < N && tree[child] != -1) {
+        *bitWord(succinct, (2 * head + side) / 64) |= 1ull << ((2 * head + side) % 64);
+        positions[tail++] = child;
+      }
+    }
+  }
+  succinct->levelStarts[succinct->height] = count;
+  free(positions);
+
+  /* Rank counts and select samples in one pass over the lines. */
+  size_t ones = 0;
+  size_t line = 0;
+  for (; line < succinct->lineCount; ++line) {
+    uint64_t *counts = succinct->lines + 8 * line;
+    counts[0] = ones;
+    size_t w = 0;
+    for (; w < LINE_WORDS && line + 1 < succinct->lineCount; ++w) {
+      size_t before = ones;
+      if (w) {
+        counts[1] |= (uint64_t)(before - counts[0]) << (9 * (w - 1));
+      }
+      ones += popCount(counts[2 + w]);
+      /* Set bit `k * SELECT_SAMPLE + 1` lies in this word if the count passes it here. */
+      size_t sample = before ? (before - 1) / SELECT_SAMPLE + 1 : 0;
+      for (; sample * SELECT_SAMPLE < ones; ++sample) {
+        succinct->samples[sample] = line;
+      }
+    }
+  }
+  return succinct;
+}
+
+/**
+ * Frees a succinct tree.
+ *
+ * @param succinct Pointer to tree object to be freed.
+ */
+void freeSuccinctTree(SuccinctTree *succinct) {
+  if (!succinct) {
+    return;
+  }
+
+  alignedFree(succinct->lines);
+  free(succinct->samples);
+  free(succinct->values);
+  free(succinct->levelStarts);
+  free(succinct);
+}
+
+/**
+ * Bytes used by a succinct tree, for comparison with `N * sizeof(int)` of the array form.
+ *
+ * @param succinct Pointer to tree object.
+ *
+ * @return Size in bytes.
+ */
+size_t succinctSize(SuccinctTree *succinct) {
+  return sizeof(*succinct) + succinct->lineCount * 64
+       + (succinct->count / SELECT_SAMPLE + 1) * sizeof(size_t) + succinct->count * sizeof(int)
+       + (succinct->height + 1) * sizeof(size_t);
+}
+
+/**
+ * Word of the bit vector, found inside its line.
+ *
+ * @param succinct Pointer to tree object.
+ * @param w Word number in the bit vector.
+ *
+ * @return Pointer to the word.
+ */
+uint64_t *bitWord(SuccinctTree *succinct, size_t w) {
+  return succinct->lines + 8 * (w / LINE_WORDS) + 2 + w % LINE_WORDS;
+}
+
+/**
+ * Number of set bits before a position.
+ *
+ * @param succinct Pointer to tree object.
+ * @param p Bit position, at most `slots`.
+ *
+ * @return Set bits in `[0, p)`.
+ */
+size_t rankOnes(SuccinctTree *succinct, size_t p) {
+  const uint64_t *line = succinct->lines + 8 * (p / (64 * LINE_WORDS));
+  size_t word = p / 64 % LINE_WORDS;
+  size_t rank = line[0];
+  if (word) {
+    rank += line[1] >> (9 * (word - 1)) & 0x1FF;
+  }
+  return rank + popCount(line[2 + word] & ((1ull << (p % 64)) - 1));
+}
+
+/**
+ * Position of a set bit.
+ *
+ * @param succinct Pointer to tree object.
+ * @param j Which set bit, counted from 1.
+ *
+ * @return Bit position of the `j`th set bit.
+ */
+size_t selectOne(SuccinctTree *succinct, size_t j) {
+  size_t line = succinct->samples[(j - 1) / SELECT_SAMPLE];
+  while (succinct->lines[8 * (line + 1)] < j) {
+    ++line;
+  }
+
+  const uint64_t *words = succinct->lines + 8 * line + 2;
+  size_t left = j - words[-2];
+  size_t w = 0;
+  int ones = popCount(words[0]);
+  while ((size_t)ones < left) {
+    left -= ones;
+    ones = popCount(words[++w]);
+  }
+
+  uint64_t word = words[w];
+  while (--left) {
+    word &= word - 1;
+  }
+  size_t bit = (line * LINE_WORDS + w) * 64;
+#ifdef __GNUC__
+  return bit + __builtin_ctzll(word);
+#else
+  while (!(word & 1)) {
+    word >>= 1;
+    ++bit;
+  }
+  return bit;
+#endif
+}
+
+/**
+ * Child of a node.
+ *
+ * @param succinct Pointer to tree object.
+ * @param x Node number.
+ * @param right 0 for the left child, 1 for the right one.
+ *
+ * @return Node number of the child, `count` if it is not present.
+ */
+size_t succinctChild(SuccinctTree *succinct, size_t x, int right) {
+  size_t slot = 2 * x + right;
+  if (!(*bitWord(succinct, slot / 64) >> (slot % 64) & 1)) {
+    return succinct->count;
+  }
+  return rankOnes(succinct, slot + 1);
+}
+
+/**
+ * Parent of a node.
+ *
+ * @param succinct Pointer to tree object.
+ * @param x Node number, not the root.
+ *
+ * @return Node number of the parent.
+ */
+size_t succinctParent(SuccinctTree *succinct, size_t x) {
+  return selectOne(succinct, x) / 2;
+}
+
+/**
+ * Level of a node, the root is on level 1.
+ *
+ * @param succinct Pointer to tree object.
+ * @param x Node number.
+ *
+ * @return Level of the node.
+ */
+size_t succinctLevel(SuccinctTree *succinct, size_t x) {
+  size_t low = 0, high = succinct->height;
+  while (high - low > 1) {
+    size_t middle = (low + high) / 2;
+    if (succinct->levelStarts[middle] <= x) {
+      low = middle;
+    } else {
+      high = middle;
+    }
+  }
+  return low + 1;
+}
+
+/**
+ * Index a node would have in the array form, found by walking up to the root.
+ *
+ * @param succinct Pointer to tree object.
+ * @param x Node number, no deeper than level 64.
+ *
+ * @return Array index of the node.
+ */
+size_t succinctPosition(SuccinctTree *succinct, size_t x) {
+  size_t path = 0;
+  size_t depth = 0;
+  while (x) {
+    size_t slot = selectOne(succinct, x);
+    path |= (size_t)(slot & 1) << ++depth;
+    x = slot / 2;
+  }
+
+  /* `path` holds the turns from the root upwards, node numbering from 1 wants them downwards. */
+  size_t k = 1;
+  while (depth) {
+    k = 2 * k + (path >> depth-- & 1);
+  }
+  return k - 1;
+}
+
+/**
+ * Looks up a key by descending the BST.
+ *
+ * @param succinct Pointer to tree object.
+ * @param key Key to be searched.
+ *
+ * @return Node number of the key, `count` if it is not there.
+ */
+size_t succinctFind(SuccinctTree *succinct, int key) {
+  size_t x = 0;
+  while (x < succinct->count && succinct->values[x] != key) {
+    x = succinctChild(succinct, x, key > succinct->values[x]);
+  }
+  return x;
+}
+
+/**
+ * Creates an empty dynamic set of one segment.
+ *
+ * @return Pointer to newly created DynamicSet object.
+ */
+DynamicSet *createDynamicSet(void) {
+  DynamicSet *set = malloc(sizeof(*set));
+  if (!set) {
+    fputs("Out of memory.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+  set->slots = NULL;
+  set->sizes = NULL;
+  set->segments = 0;
+  set->count = 0;
+  set->index = NULL;
+  set->counts = NULL;
+  set->scratch = NULL;
+  resizeDynamicSet(set, 1, NULL);
+  return set;
+}
+
+/**
+ * Frees a dynamic set.
+ *
+ * @param set Pointer to set object to be freed.
+ */
+void freeDynamicSet(DynamicSet *set) {
+  if (!set) {
+    return;
+  }
+
+  alignedFree(set->slots);
+  free(set->sizes);
+  freeSearchTree(set->index);
+  free(set->counts);
+  free(set->scratch);
+  free(set);
+}
+
+/**
+ * Moves the keys into a new array of `segments` segments, spread evenly, and rebuilds the index.
+ *
+ * @param set Pointer to set object.
+ * @param segments New number of segments, a power of two with room for every key.
+ * @param key Key to be added on the way, NULL for none.
+ */
+void resizeDynamicSet(DynamicSet *set, size_t segments, const int *key) {
+  size_t capacity = segments * SEGMENT_SIZE;
+  int *scratch = malloc((capacity + 1) * sizeof(int));
+  int *slots = alignedAlloc(64, capacity * sizeof(int));
+  size_t *sizes = calloc(segments, sizeof(size_t));
+  size_t *counts = calloc(segments + 1, sizeof(size_t));
+  if (!scratch || !slots || !sizes || !counts) {
+    fputs("Out of memory.\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+
+  size_t n = gatherKeys(set, 0, set->segments, scratch);
+  if (key) {
+    n = insertSorted(scratch, n, *key);
+  }
+  alignedFree(set->slots);
+  free(set->sizes);
+  free(set->counts);
+  free(set->scratch);
+  set->slots = slots;
+  set->sizes = sizes;
+  set->counts = counts;
+  set->scratch = scratch;
+  set->segments = segments;
+  spreadKeys(set, 0, segments, scratch, n);
+  rebuildIndex(set);
+}
+
+/**
+ * Builds the index over the largest key of every segment anew.
+ *
+ * @param set Pointer to set object.
+ */
+void rebuildIndex(DynamicSet *set) {
+  int head = INT_MIN;
+  size_t s = 0;
+  for (; s < set->segments; ++s) {
+    if (set->sizes[s]) {
+      head = set->slots[s * SEGMENT_SIZE + set->sizes[s] - 1];
+    }
+    set->scratch[s] = head;
+  }
+  freeSearchTree(set->index);
+  set->index = createSearchTree(set->scratch, set->segments);
+}
+
+/**
+ * Patches the index entries of a range of segments, and of the empty segments right after it that
+ * repeat its largest key.
+ *
+ * @param set Pointer to set object.
+ * @param first, end Range of segments that changed.
+ */
+void refreshHeads(DynamicSet *set, size_t first, size_t end) {
+  SearchTree *index = set->index;
+  int head = first ? index->keys[searchNode(index, first - 1)] : INT_MIN;
+  size_t s = first;
+  for (; s < set->segments && (s < end || !set->sizes[s]); ++s) {
+    if (set->sizes[s]) {
+      head = set->slots[s * SEGMENT_SIZE + set->sizes[s] - 1];
+    }
+    index->keys[searchNode(index, s)] = head;
+  }
+}
+
+/**
+ * Adds to the size of a segment in the Fenwick tree. A shrink is passed as its wrapped around
+ * negative, the sums come out right in unsigned arithmetic.
+ *
+ * @param set Pointer to set object.
+ * @param s Segment.
+ * @param delta Change of its size.
+ */
+void countAdd(DynamicSet *set, size_t s, size_t delta) {
+  size_t i = s + 1;
+  for (; i <= set->segments; i += i & (0 - i)) {
+    set->counts[i] += delta;
+  }
+}
+
+/**
+ * Number of keys in the segments before one.
+ *
+ * @param set Pointer to set object.
+ * @param s Segment.
+ *
+ * @return Sum of the sizes of segments `[0, s)`.
+ */
+size_t countBefore(DynamicSet *set, size_t s) {
+  size_t sum = 0;
+  for (; s; s &= s - 1) {
+    sum += set->counts[s];
+  }
+  return sum;
+}
+
+/**
+ * Copies the keys of a range of segments out in order.
+ *
+ * @param set Pointer to set object.
+ * @param first, end Range of segments.
+ * @param out Array with room for the keys.
+ *
+ * @return Number of keys copied.
+ */
+size_t gatherKeys(DynamicSet *set, size_t first, size_t end, int *out) {
+  size_t n = 0;
+  for (; first < end; ++first) {
+    memcpy(out + n, set->slots + first * SEGMENT_SIZE, set->sizes[first] * sizeof(int));
+    n += set->sizes[first];
+  }
+  return n;
+}
+
+/**
+ * Inserts a key into a sorted array that has room for it.
+ *
+ * @param keys Sorted keys.
+ * @param n Number of keys.
+ * @param key Key to be inserted.
+ *
+ * @return New number of keys.
+ */
+size_t insertSorted(int *keys, size_t n, int key) {
+  size_t at = n;
+  while (at && keys[at - 1] > key) {
+    keys[at] = keys[at - 1];
+    --at;
+  }
+  keys[at] = key;
+  return n + 1;
+}
+
+/**
+ * Spreads sorted keys evenly over a range of segments, updating their sizes and the Fenwick tree.
+ * The index is left to the caller.
+ *
+ * @param set Pointer to set object.
+ * @param first, end Range of segments.
+ * @param keys Keys in increasing order.
+ * @param n Number of keys, at most the slots of the range.
+ */
+void spreadKeys(DynamicSet *set, size_t first, size_t end, const int *keys, size_t n) {
+  size_t width = end - first;
+  size_t s = 0;
+  for (; s < width; ++s) {
+    size_t share = n / width + (s < n % width);
+    memcpy(set->slots + (first + s) * SEGMENT_SIZE, keys, share * sizeof(int));
+    keys += share;
+    countAdd(set, first + s, share - set->sizes[first + s]);
+    set->sizes[first + s] = share;
+  }
+}
+
+/**
+ * Restores the density bounds around a segment that is full (with a key waiting to go in) or
+ * has run low. The aligned ranges around the segment are tried from the segment itself upwards;
+ * the bounds go from 1 (insert) and 1/8 (erase) at a single segment to 3/4 and 1/4 at the whole
+ * array, so larger ranges, which cost more to spread, are kept further from their limits. If no
+ * range qualifies the array doubles or halves.
+ *
+ * @param set Pointer to set object.
+ * @param s Segment that went out of bounds.
+ * @param key Key to be inserted, NULL after an erase.
+ */
+void rebalanceSegments(DynamicSet *set, size_t s, const int *key) {
+  int levels = floorLog2(set->segments);
+  int level = 0;
+  for (; level <= levels; ++level) {
+    size_t first = s >> level << level;
+    size_t end = first + ((size_t)1 << level);
+    size_t total = key != NULL;
+    size_t t = first;
+    for (; t < end; ++t) {
+      total += set->sizes[t];
+    }
+
+    double fill = (double)total / ((end - first) * SEGMENT_SIZE);
+    double depth = levels ? (double)level / levels : 1.0;
+    if (key ? fill <= 1.0 - 0.25 * depth : fill >= 0.125 + 0.125 * depth) {
+      size_t n = gatherKeys(set, first, end, set->scratch);
+      if (key) {
+        n = insertSorted(set->scratch, n, *key);
+      }
+      spreadKeys(set, first, end, set->scratch, n);
+      refreshHeads(set, first, end);
+      return;
+    }
+  }
+
+  if (key) {
+    resizeDynamicSet(set, 2 * set->segments, key);
+  } else if (set->segments > 1) {
+    resizeDynamicSet(set, set->segments / 2, NULL);
+  }
+}
+
+/**
+ * Finds the segment a key belongs in: the first one whose largest key is not less than it, or the
+ * last one if every key is less.
+ *
+ * @param set Pointer to set object.
+ * @param key Key to be placed.
+ *
+ * @return Segment number.
+ */
+size_t locateSegment(DynamicSet *set, int key) {
+  size_t s = searchRank(set->index, searchLowerBound(set->index, key));
+  if (s == set->segments) {
+    return s - 1;
+  }
+  /* Only INT_MIN can land on the leading empty segments. */
+  while (!set->sizes[s] && s + 1 < set->segments) {
+    ++s;
+  }
+  return s;
+}
+
+/**
+ * Finds the first key not less than `key` in a segment by counting the smaller ones, which
+ * vectorizes and has no branch to mispredict.
+ *
+ * @param keys Keys of the segment.
+ * @param n Number of keys.
+ * @param key Key to be searched.
+ *
+ * @return Offset in the segment, `n` if every key is less.
+ */
+size_t segmentLowerBound(const int *keys, size_t n, int key) {
+  size_t less = 0;
+  size_t i;
+  OMP(simd reduction(+:less))
+  for (i = 0; i < n; ++i) {
+    less += keys[i] < key;
+  }
+  return less;
+}
+
+/**
+ * Adds a key to a set.
+ *
+ * @param set Pointer to set object.
+ * @param key Key to be added.
+ *
+ * @return 1 if the key was added, 0 if it was already there.
+ */
+int dynamicInsert(DynamicSet *set, int key) {
+  size_t s = locateSegment(set, key);
+  int *segment = set->slots + s * SEGMENT_SIZE;
+  size_t size = set->sizes[s];
+  size_t at = segmentLowerBound(segment, size, key);
+  if (at < size && segment[at] == key) {
+    return 0;
+  }
+
+  ++set->count;
+  if (size == SEGMENT_SIZE) {
+    rebalanceSegments(set, s, &key);
+    return 1;
+  }
+  memmove(segment + at + 1, segment + at, (size - at) * sizeof(int));
+  segment[at] = key;
+  set->sizes[s] = size + 1;
+  countAdd(set, s, 1);
+  if (at == size) {
+    refreshHeads(set, s, s + 1);
+  }
+  return 1;
+}
+
+/**
+ * Removes a key from a set.
+ *
+ * @param set Pointer to set object.
+ * @param key Key to be removed.
+ *
+ * @return 1 if the key was removed, 0 if it was not there.
+ */
+int dynamicErase(DynamicSet *set, int key) {
+  size_t s = locateSegment(set, key);
+  int *segment = set->slots + s * SEGMENT_SIZE;
+  size_t size = set->sizes[s];
+  size_t at = segmentLowerBound(segment, size, key);
+  if (at == size || segment[at] != key) {
+    return 0;
+  }
+
+  --set->count;
+  memmove(segment + at, segment + at + 1, (size - at - 1) * sizeof(int));
+  set->sizes[s] = size - 1;
+  countAdd(set, s, (size_t)-1);
+  if (at == size - 1) {
+    refreshHeads(set, s, s + 1);
+  }
+  if (size - 1 < SEGMENT_SIZE / 8) {
+    rebalanceSegments(set, s, NULL);
+  }
+  return 1;
+}
+
+/**
+ * Position that stands for past the end in the lookups of a dynamic set.
+ *
+ * @param set Pointer to set object.
+ *
+ * @return Number of slots.
+ */
+size_t dynamicEnd(DynamicSet *set) {
+  return set->segments * SEGMENT_SIZE;
+}
+
+/**
+ * Finds the first key not less than `key`. Positions are only valid until the next insert or
+ * erase.
+ *
+ * @param set Pointer to set object.
+ * @param key Key to be searched.
+ *
+ * @return Position in `slots`, `dynamicEnd` if every key is less.
+ */
+size_t dynamicLowerBound(DynamicSet *set, int key) {
+  size_t s = locateSegment(set, key);
+  size_t at = segmentLowerBound(set->slots + s * SEGMENT_SIZE, set->sizes[s], key);
+  return at < set->sizes[s] ? s * SEGMENT_SIZE + at : dynamicEnd(set);
+}
+
+/**
+ * Finds the first key greater than `key`.
+ *
+ * @param set Pointer to set object.
+ * @param key Key to be searched.
+ *
+ * @return Position in `slots`, `dynamicEnd` if no key is greater.
+ */
+size_t dynamicUpperBound(DynamicSet *set, int key) {
+  return key == INT_MAX ? dynamicEnd(set) : dynamicLowerBound(set, key + 1);
+}
+
+/**
+ * Looks up a key.
+ *
+ * @param set Pointer to set object.
+ * @param key Key to be searched.
+ *
+ * @return Position of the key in `slots`, `dynamicEnd` if it is not there.
+ */
+size_t dynamicFind(DynamicSet *set, int key) {
+  size_t i = dynamicLowerBound(set, key);
+  return i < dynamicEnd(set) && set->slots[i] == key ? i : dynamicEnd(set);
+}
+
+/**
+ * Turns a position into the number of keys before it in sorted order.
+ *
+ * @param set Pointer to set object.
+ * @param i Position in `slots`, `dynamicEnd` stands for past the end.
+ *
+ * @return Sorted rank, `count` for past the end.
+ */
+size_t dynamicRank(DynamicSet *set, size_t i) {
+  if (i >= dynamicEnd(set)) {
+    return set->count;
+  }
+  return countBefore(set, i / SEGMENT_SIZE) + i % SEGMENT_SIZE;
+}
+
+/**
+ * Counts the keys in a closed range.
+ *
+ * @param set Pointer to set object.
+ * @param low, high Bounds of the range.
+ *
+ * @return Number of keys `x` with `low <= x <= high`.
+ */
+size_t dynamicCount(DynamicSet *set, int low, int high) {
+  if (low > high) {
+    return 0;
   }
+  return dynamicRank(set, dynamicUpperBound(set, high)) - dynamicRank(set, dynamicLowerBound(set, low));
 }
 
+#ifndef BENCHMARK
 int main() {
   size_t N = 15;
 
@@ -48,3 +1424,4 @@ int main() {
 
   return 0;
 }
+#endif